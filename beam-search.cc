@@ -0,0 +1,125 @@
+#include "beam-search.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "heuristic.h"
+#include "level.h"
+#include "search.h"
+#include "search-monitor.h"
+#include "state-set.h"
+
+namespace {
+
+// A successor state that may be kept in the next layer.
+struct Candidate {
+  int estimate;
+  std::string key;
+  int32_t parent;
+
+  // The move back to the parent, if any (see Level::SuccessorsExcept()).
+  std::optional<Move> undo;
+
+  // Orders candidates by how promising they are. Ties are broken by key, so
+  // that the result does not depend on the order of generation.
+  bool operator<(const Candidate &other) const {
+    return std::tie(estimate, key) < std::tie(other.estimate, other.key);
+  }
+};
+
+}  // namespace
+
+SolveResult BeamSearch(const Level &initial_level, const SolveOptions &options, int width) {
+  SearchMonitor monitor(options);
+  SolveResult result;
+  result.strategy = SearchStrategy::BEAM;
+  if (initial_level.Solved()) {
+    result.status = SolveStatus::SOLVED;
+    result.steps.push_back(initial_level);
+    return result;
+  }
+  result.lower_bound = LowerBound(initial_level);
+
+  // All states kept so far, in order of depth, the id of the state from which
+  // each was reached (or -1 for the initial state) and the move back to it.
+  StateSet states(initial_level.KeySize());
+  std::vector<int32_t> parents;
+  std::vector<std::optional<Move>> undo_moves;
+  states.Insert(initial_level.Key());
+  parents.push_back(-1);
+  undo_moves.emplace_back();
+
+  std::vector<Candidate> candidates;
+  auto memory_usage = [&]() {
+    return states.MemoryUsage() + parents.capacity() * sizeof(parents[0]) +
+        undo_moves.capacity() * sizeof(undo_moves[0]) +
+        candidates.capacity() * (sizeof(Candidate) + initial_level.KeySize());
+  };
+  bool pruned = false;
+  uint32_t layer_begin = 0;
+  uint32_t layer_end = 1;
+  for (int depth = 0; layer_begin < layer_end; ++depth) {
+    candidates.clear();
+    for (uint32_t id = layer_begin; id < layer_end; ++id) {
+      std::optional<SolveStatus> status = monitor.Check(depth, layer_end - id, states.Size());
+      if (!status && options.max_memory > 0 && memory_usage() > options.max_memory) {
+        status = SolveStatus::MEMORY_LIMIT_EXCEEDED;
+      }
+      if (status) {
+        result.status = *status;
+        result.expanded = states.Size();
+        return result;
+      }
+      Level level = initial_level.FromKey(states.Key(id));
+      for (auto &[next_level, undo] : level.SuccessorsExcept(undo_moves[id])) {
+        if (next_level.Solved()) {
+          for (int32_t j = id; j >= 0; j = parents[j]) {
+            result.steps.push_back(initial_level.FromKey(states.Key(j)));
+          }
+          std::reverse(result.steps.begin(), result.steps.end());
+          result.steps.push_back(std::move(next_level));
+          result.status = SolveStatus::SOLVED;
+          result.expanded = states.Size();
+          return result;
+        }
+        std::string key = next_level.Key();
+        if (states.Find(key)) continue;
+        candidates.push_back({
+            .estimate = EstimateDistance(next_level),
+            .key = std::move(key),
+            .parent = int32_t(id),
+            .undo = undo});
+      }
+    }
+
+    // Remove duplicates within the layer, then keep the best candidates.
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate &a, const Candidate &b) {
+          return std::tie(a.key, a.parent) < std::tie(b.key, b.parent);
+        });
+    candidates.erase(
+        std::unique(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) { return a.key == b.key; }),
+        candidates.end());
+    if (candidates.size() > width) {
+      std::nth_element(candidates.begin(), candidates.begin() + width, candidates.end());
+      candidates.resize(width);
+      pruned = true;
+    }
+    for (const Candidate &candidate : candidates) {
+      states.Insert(candidate.key);
+      parents.push_back(candidate.parent);
+      undo_moves.push_back(candidate.undo);
+    }
+    layer_begin = layer_end;
+    layer_end = states.Size();
+  }
+  result.status = pruned ? SolveStatus::INCOMPLETE : SolveStatus::UNSOLVABLE;
+  result.expanded = states.Size();
+  return result;
+}
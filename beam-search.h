@@ -0,0 +1,20 @@
+#ifndef BEAM_SEARCH_H_INCLUDED
+#define BEAM_SEARCH_H_INCLUDED
+
+#include "level.h"
+#include "search.h"
+
+// Searches for a solution by beam search: a breadth-first search that only
+// keeps the `width` most promising states of each layer, as ranked by
+// EstimateDistance() (see heuristic.h). Successors that were already kept in
+// an earlier layer, or that occur more than once in a layer, are discarded
+// before ranking.
+//
+// Memory use is proportional to `width` times the depth reached, so this can
+// find (usually long) solutions for levels that are far too large for other
+// searches. Since states are pruned, failing to find a solution does not prove
+// that there is none: the result is then INCOMPLETE, unless no state was ever
+// pruned, in which case the level is UNSOLVABLE.
+SolveResult BeamSearch(const Level &initial_level, const SolveOptions &options, int width);
+
+#endif  // ndef BEAM_SEARCH_H_INCLUDED
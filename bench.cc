@@ -0,0 +1,242 @@
+// Microbenchmarks for the primitives of the Level class.
+//
+// For each level, a fixed sample of states is taken from the breadth-first
+// enumeration of its state space, and each primitive is timed on the sample.
+// The enumeration stops early when it reaches a memory limit, so on levels
+// with huge state spaces (like those consisting of several regions, whose
+// state space is the product of theirs), only the states nearest to the
+// initial level are sampled.
+// Each measurement is repeated, and the fastest run is reported, which makes
+// the results fairly stable between runs.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "enumerate.h"
+#include "level.h"
+
+namespace {
+
+// Number of heap allocations made so far, counted by operator new below.
+std::atomic<int64_t> allocations = 0;
+
+}  // namespace
+
+// GCC does not realize that the replacement operators below pair malloc() with
+// free(), and warns about every inlined deallocation.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(size_t size) {
+  ++allocations;
+  if (void *p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+class LevelBenchmark {
+public:
+  // Returns copies of `level` in which each group has been moved left or
+  // right (where possible), but in which gravity and connections have not
+  // been applied yet.
+  static std::vector<Level> PartialMoves(const Level &level) {
+    std::vector<Level> result;
+    std::vector<char> seen(level.groups + 1, char{false});
+    for (int r = 1; r + 1 < level.height; ++r) {
+      for (int c = 1; c + 1 < level.width; ++c) {
+        int g = level.grid[level.Index(r, c)].group;
+        if (g == 0 || seen[g]) continue;
+        seen[g] = true;
+        for (int dc : {-1, +1}) {
+          Level copy = level;
+          if (copy.TryMove(r, c, 0, dc)) result.push_back(std::move(copy));
+        }
+      }
+    }
+    return result;
+  }
+
+  static void DropDown(Level &level) {
+    level.DropDown();
+  }
+
+  static void UpdateConnections(Level &level) {
+    level.UpdateConnections();
+  }
+};
+
+namespace {
+
+struct Measurement {
+  int64_t ops = 0;
+  double seconds = 0;
+  int64_t allocations = 0;
+};
+
+// Runs `prepare` (untimed) and then `run` (timed), `repeat` times, and returns
+// the fastest measurement. `run` returns the number of operations it did.
+Measurement Measure(int repeat, const std::function<void()> &prepare, const std::function<int64_t()> &run) {
+  Measurement best;
+  for (int i = 0; i < repeat; ++i) {
+    prepare();
+    int64_t allocations_before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    int64_t ops = run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    int64_t allocations_after = allocations;
+    if (i == 0 || elapsed.count() < best.seconds) {
+      best = {.ops = ops, .seconds = elapsed.count(), .allocations = allocations_after - allocations_before};
+    }
+  }
+  return best;
+}
+
+void PrintMeasurement(const std::string &level, const char *primitive, const Measurement &m) {
+  std::cout << std::left << std::setw(24) << level << ' '
+      << std::setw(18) << primitive << std::right << ' '
+      << std::setw(8) << m.ops << ' '
+      << std::setw(10) << std::fixed << std::setprecision(1) << m.seconds * 1e9 / m.ops << ' '
+      << std::setw(10) << std::setprecision(2) << double(m.allocations) / m.ops << ' '
+      << std::setw(12) << std::setprecision(0) << m.ops / m.seconds << '\n' << std::flush;
+}
+
+void BenchmarkLevel(const std::string &name, const Level &initial, int samples, int repeat, size_t max_memory) {
+  Enumeration enumeration = Enumerate(initial, {.max_memory = max_memory});
+  const uint32_t n = enumeration.states.Size();
+  std::vector<Level> states;
+  for (int i = 0; i < samples && i < n; ++i) {
+    states.push_back(initial.FromKey(enumeration.states.Key(uint64_t(i) * n / std::min<uint32_t>(samples, n))));
+  }
+
+  // All valid moves of all sampled states, with the state they apply to.
+  std::vector<std::pair<Move, const Level*>> moves;
+  std::vector<Level> partial;
+  for (const Level &state : states) {
+    for (const auto &[move, next_level] : state.Moves()) moves.push_back({move, &state});
+    for (Level &level : LevelBenchmark::PartialMoves(state)) partial.push_back(std::move(level));
+  }
+
+  // MoveGroup: moves are executed on fresh copies of the states.
+  std::vector<Level> copies;
+  PrintMeasurement(name, "MoveGroup", Measure(repeat,
+      [&]() {
+        copies.clear();
+        for (const auto &[move, state] : moves) copies.push_back(*state);
+      },
+      [&]() {
+        int64_t ops = 0;
+        for (size_t k = 0; k < moves.size(); ++k) ops += copies[k].Apply(moves[k].first);
+        return ops;
+      }));
+
+  // DropDown and UpdateConnections: applied to states in which a group has
+  // been moved, but the move has not been completed.
+  PrintMeasurement(name, "DropDown", Measure(repeat,
+      [&]() { copies = partial; },
+      [&]() {
+        for (Level &level : copies) LevelBenchmark::DropDown(level);
+        return int64_t(copies.size());
+      }));
+  std::vector<Level> dropped = partial;
+  for (Level &level : dropped) LevelBenchmark::DropDown(level);
+  PrintMeasurement(name, "UpdateConnections", Measure(repeat,
+      [&]() { copies = dropped; },
+      [&]() {
+        for (Level &level : copies) LevelBenchmark::UpdateConnections(level);
+        return int64_t(copies.size());
+      }));
+
+  volatile int64_t sink = 0;
+  PrintMeasurement(name, "Solved", Measure(repeat,
+      []() {},
+      [&]() {
+        for (const Level &level : states) sink = sink + level.Solved();
+        return int64_t(states.size());
+      }));
+  PrintMeasurement(name, "Successors", Measure(repeat,
+      []() {},
+      [&]() {
+        for (const Level &level : states) sink = sink + level.Successors().size();
+        return int64_t(states.size());
+      }));
+  PrintMeasurement(name, "Key", Measure(repeat,
+      []() {},
+      [&]() {
+        for (const Level &level : states) sink = sink + level.Key().size();
+        return int64_t(states.size());
+      }));
+}
+
+void PrintUsage() {
+  std::cout << "Usage: bench [--samples=N] [--repeat=N] [--max-mib=M] <level.txt>...\n"
+      "\n"
+      "Times the Level primitives on N states (default 500) sampled from the\n"
+      "state space of each level. Each measurement is repeated (default 5 times)\n"
+      "and the fastest run is reported.\n"
+      "\n"
+      "The state space is enumerated breadth-first until it uses about M MiB\n"
+      "(default 16), so for larger state spaces only the states nearest to the\n"
+      "initial level are sampled.\n" << std::flush;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int samples = 500;
+  int repeat = 5;
+  size_t max_memory = size_t{16} << 20;
+  std::vector<std::string> filenames;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg.starts_with("--samples=")) {
+      samples = std::atoi(argv[i] + arg.find('=') + 1);
+    } else if (arg.starts_with("--repeat=")) {
+      repeat = std::atoi(argv[i] + arg.find('=') + 1);
+    } else if (arg.starts_with("--max-mib=")) {
+      max_memory = size_t(std::atoi(argv[i] + arg.find('=') + 1)) << 20;
+    } else if (arg.starts_with("-")) {
+      PrintUsage();
+      return 1;
+    } else {
+      filenames.push_back(argv[i]);
+    }
+  }
+  if (filenames.empty() || samples < 1 || repeat < 1 || max_memory == 0) {
+    PrintUsage();
+    return 1;
+  }
+  std::cout << std::left << std::setw(24) << "level" << ' '
+      << std::setw(18) << "primitive" << std::right << ' '
+      << std::setw(8) << "ops" << ' '
+      << std::setw(10) << "ns/op" << ' '
+      << std::setw(10) << "allocs/op" << ' '
+      << std::setw(12) << "ops/s" << '\n';
+  for (const std::string &filename : filenames) {
+    std::ifstream ifs(filename);
+    std::optional<Level> level = ReadLevel(ifs);
+    if (!level) {
+      std::cerr << "Failed to read level (" << filename << ")!" << std::endl;
+      return 1;
+    }
+    std::string name = filename.substr(filename.find_last_of('/') + 1);
+    BenchmarkLevel(name, *level, samples, repeat, max_memory);
+  }
+}
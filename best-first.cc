@@ -0,0 +1,145 @@
+#include "best-first.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+#include "heuristic.h"
+#include "level.h"
+#include "search.h"
+#include "search-monitor.h"
+#include "state-set.h"
+
+namespace {
+
+struct QueueEntry {
+  double f;
+  int estimate;
+  uint32_t id;
+
+  // Number of moves to the state when this entry was added. If the state was
+  // reached by a shorter path later, this entry is outdated.
+  uint32_t g;
+
+  bool operator>(const QueueEntry &other) const {
+    return std::tie(f, estimate, id) > std::tie(other.f, other.estimate, other.id);
+  }
+};
+
+}  // namespace
+
+SolveResult BestFirstSearch(const Level &initial_level, const SolveOptions &options, const BestFirstWeights &weights) {
+  SearchMonitor monitor(options);
+  SolveResult result;
+  result.strategy = SearchStrategy::BEST_FIRST;
+  if (initial_level.Solved()) {
+    result.status = SolveStatus::SOLVED;
+    result.steps.push_back(initial_level);
+    return result;
+  }
+
+  // Greedy search does not care about the length of the solution, so it can
+  // stop as soon as a solved state is generated, instead of when it would be
+  // expanded.
+  const bool greedy = weights.g == 0;
+  const bool admissible = weights.g == 1 && weights.h == 1;
+
+  // Greedy search is guided by the estimate, which is not a lower bound but
+  // distinguishes states better. Other searches use the lower bound, so that
+  // weighted A* solutions are at most `weights.h` times longer than optimal.
+  auto heuristic = [&](const HeuristicValues &values) {
+    return greedy ? values.estimate : values.lower_bound;
+  };
+
+  std::optional<PatternDatabase> pdb;
+  if (!greedy && options.pattern_database) pdb.emplace(initial_level, std::max(options.threads, 1));
+  const PatternDatabase *pdb_ptr = pdb ? &*pdb : nullptr;
+
+  StateSet states(initial_level.KeySize());
+  std::vector<int32_t> parents;
+  // The move from each state back to its parent, if any (see
+  // Level::SuccessorsExcept()). The parent is always closed.
+  std::vector<std::optional<Move>> undo_moves;
+  std::vector<uint32_t> distance;
+  std::vector<char> closed;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+  auto memory_usage = [&]() {
+    return states.MemoryUsage() + parents.capacity() * sizeof(parents[0]) +
+        undo_moves.capacity() * sizeof(undo_moves[0]) + distance.capacity() * sizeof(distance[0]) + closed.capacity() +
+        queue.size() * sizeof(QueueEntry) + (pdb ? pdb->MemoryUsage() : 0);
+  };
+  auto add_solution = [&](int32_t id) {
+    for (int32_t j = id; j >= 0; j = parents[j]) {
+      result.steps.push_back(initial_level.FromKey(states.Key(j)));
+    }
+    std::reverse(result.steps.begin(), result.steps.end());
+    result.status = SolveStatus::SOLVED;
+  };
+
+  states.Insert(initial_level.Key());
+  parents.push_back(-1);
+  undo_moves.emplace_back();
+  distance.push_back(0);
+  closed.push_back(false);
+  HeuristicValues initial_values = EvaluateHeuristics(initial_level, pdb_ptr);
+  queue.push({
+      .f = weights.h * heuristic(initial_values),
+      .estimate = initial_values.estimate,
+      .id = 0,
+      .g = 0});
+  result.lower_bound = initial_values.lower_bound;
+
+  while (!queue.empty() && result.status != SolveStatus::SOLVED) {
+    const QueueEntry entry = queue.top();
+    queue.pop();
+    if (closed[entry.id] || entry.g != distance[entry.id]) continue;
+    std::optional<SolveStatus> status = monitor.Check(entry.g, queue.size(), states.Size());
+    if (!status && options.max_memory > 0 && memory_usage() > options.max_memory) {
+      status = SolveStatus::MEMORY_LIMIT_EXCEEDED;
+    }
+    if (status) {
+      result.status = *status;
+      break;
+    }
+    if (admissible) result.lower_bound = std::max<int>(result.lower_bound, entry.f);
+    closed[entry.id] = true;
+    Level level = initial_level.FromKey(states.Key(entry.id));
+    if (!greedy && level.Solved()) {
+      add_solution(entry.id);
+      break;
+    }
+    const uint32_t next_g = entry.g + 1;
+    for (auto &[next_level, undo] : level.SuccessorsExcept(undo_moves[entry.id])) {
+      if (greedy && next_level.Solved()) {
+        add_solution(entry.id);
+        result.steps.push_back(std::move(next_level));
+        break;
+      }
+      auto [id, inserted] = states.Insert(next_level.Key());
+      if (inserted) {
+        parents.push_back(entry.id);
+        undo_moves.push_back(undo);
+        distance.push_back(next_g);
+        closed.push_back(false);
+      } else if (closed[id] || distance[id] <= next_g) {
+        continue;
+      } else {
+        parents[id] = entry.id;
+        undo_moves[id] = undo;
+        distance[id] = next_g;
+      }
+      HeuristicValues values = EvaluateHeuristics(next_level, pdb_ptr);
+      queue.push({
+          .f = weights.g * next_g + weights.h * heuristic(values),
+          .estimate = values.estimate,
+          .id = id,
+          .g = next_g});
+    }
+  }
+  result.expanded = states.Size();
+  return result;
+}
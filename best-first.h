@@ -0,0 +1,33 @@
+#ifndef BEST_FIRST_H_INCLUDED
+#define BEST_FIRST_H_INCLUDED
+
+#include "level.h"
+#include "search.h"
+
+// Weights of the priority f = g * g_weight + h * h_weight by which best-first
+// search expands states, where g is the number of moves made so far and h is
+// the LowerBound() heuristic (see heuristic.h), raised to the bound of the
+// pattern database if SolveOptions::pattern_database is set, or
+// EstimateDistance() for greedy search. Ties are broken by EstimateDistance(),
+// and then in order of discovery.
+//
+//  - A* uses {1, 1}, and finds shortest solutions.
+//  - Weighted A* uses {1, W} with W > 1, and finds solutions at most W times
+//    longer than the shortest one, usually expanding far fewer states.
+//  - Greedy best-first search uses {0, 1}, and ignores the length of the
+//    solution altogether.
+struct BestFirstWeights {
+  double g = 1;
+  double h = 1;
+};
+
+// Searches for a solution by best-first search with the given weights. States
+// are stored as packed keys (like in CompactSearch), and states that have
+// been expanded are never expanded again, which is safe for A* since the
+// heuristic is consistent.
+//
+// When the search is aborted, the result's lower bound is set if the weights
+// are those of A*.
+SolveResult BestFirstSearch(const Level &initial_level, const SolveOptions &options, const BestFirstWeights &weights);
+
+#endif  // ndef BEST_FIRST_H_INCLUDED
@@ -0,0 +1,176 @@
+#include "checkpoint.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "compact-search.h"
+#include "level.h"
+#include "search-stats.h"
+#include "solution-cache.h"
+
+namespace {
+
+const char CHECKPOINT_HEADER[] = "jelly-checkpoint 1";
+
+struct CheckpointPaths {
+  explicit CheckpointPaths(const std::string &dir) :
+      header((std::filesystem::path(dir) / "checkpoint.txt").string()),
+      keys((std::filesystem::path(dir) / "keys.bin").string()),
+      parents((std::filesystem::path(dir) / "parents.bin").string()) {}
+
+  std::string header;
+  std::string keys;
+  std::string parents;
+};
+
+// Reads `size` bytes from the start of the file at `path` into `data`.
+bool ReadPrefix(const std::string &path, size_t size, char *data) {
+  std::ifstream ifs(path, std::ios::binary);
+  return ifs.read(data, size) && ifs.gcount() == size;
+}
+
+// Appends `size` bytes to the file at `path`, after truncating it to `offset`
+// bytes (to discard data from an interrupted write).
+bool Append(const std::string &path, size_t offset, const char *data, size_t size) {
+  std::error_code ec;
+  std::filesystem::resize_file(path, offset, ec);
+  if (ec) return false;
+  std::ofstream ofs(path, std::ios::binary | std::ios::app);
+  return ofs.write(data, size) && ofs.flush();
+}
+
+}  // namespace
+
+std::optional<CompactSearch> ReadCheckpoint(const std::string &dir, const Level &level) {
+  const CheckpointPaths paths(dir);
+  std::ifstream ifs(paths.header);
+  std::string line;
+  if (!std::getline(ifs, line) || line != CHECKPOINT_HEADER) {
+    std::cerr << "Failed to read checkpoint (" << paths.header << ")!" << std::endl;
+    return {};
+  }
+  if (!std::getline(ifs, line) || line != "level: " + CanonicalLayout(level)) {
+    std::cerr << "Checkpoint is for a different level (" << paths.header << ")!" << std::endl;
+    return {};
+  }
+
+  CompactSearch search(level.KeySize());
+  SearchStats &stats = search.stats;
+  size_t size = 0;
+  bool valid = true;
+  while (valid && std::getline(ifs, line)) {
+    std::istringstream iss(line);
+    std::string key;
+    iss >> key;
+    if (key == "states:") {
+      valid = bool(iss >> size);
+    } else if (key == "next:") {
+      valid = bool(iss >> search.next);
+    } else if (key == "layer-end:") {
+      valid = bool(iss >> search.layer_end);
+    } else if (key == "depth:") {
+      valid = bool(iss >> search.depth);
+    } else if (key == "generated:") {
+      valid = bool(iss >> stats.generated);
+    } else if (key == "inserted:") {
+      valid = bool(iss >> stats.inserted);
+    } else if (key == "goal-checks:") {
+      valid = bool(iss >> stats.goal_checks);
+    } else if (key == "seconds:") {
+      valid = bool(iss >> stats.total_seconds);
+    } else if (key == "layers:") {
+      SearchStats::Layer layer;
+      while (iss >> layer.states >> layer.seconds) stats.layers.push_back(layer);
+    }
+  }
+  valid = valid && size > 0 && search.next <= search.layer_end && search.layer_end <= size &&
+      !stats.layers.empty();
+
+  std::string keys(size * level.KeySize(), '\0');
+  search.parents.resize(size);
+  if (!valid || !ReadPrefix(paths.keys, keys.size(), keys.data()) ||
+      !ReadPrefix(paths.parents, size * sizeof(int32_t), reinterpret_cast<char*>(search.parents.data()))) {
+    std::cerr << "Invalid checkpoint (" << dir << ")!" << std::endl;
+    return {};
+  }
+  for (size_t id = 0; id < size; ++id) {
+    std::string_view key = std::string_view(keys).substr(id * level.KeySize(), level.KeySize());
+    int32_t parent = search.parents[id];
+    if (!search.states.Insert(key).second || (id == 0 ? parent != -1 : parent < 0 || parent >= id)) {
+      std::cerr << "Invalid checkpoint (" << dir << ")!" << std::endl;
+      return {};
+    }
+  }
+  return search;
+}
+
+std::optional<CheckpointWriter> CheckpointWriter::Create(
+    const std::string &dir, const Level &level, const CompactSearch &search, bool resumed) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  const CheckpointPaths paths(dir);
+  if (!resumed) {
+    // Remove the header first, so that an interrupted write never leaves a
+    // checkpoint that refers to data from a different search.
+    std::filesystem::remove(paths.header, ec);
+    for (const std::string &path : {paths.keys, paths.parents}) {
+      if (!std::ofstream(path, std::ios::binary | std::ios::trunc)) {
+        std::cerr << "Failed to create checkpoint file (" << path << ")!" << std::endl;
+        return {};
+      }
+    }
+  }
+  return CheckpointWriter(dir, CanonicalLayout(level), resumed ? search.states.Size() : 0);
+}
+
+bool CheckpointWriter::Write(const CompactSearch &search, double seconds) {
+  const CheckpointPaths paths(dir);
+  const size_t size = search.states.Size();
+  const size_t key_size = search.states.KeySize();
+  std::string_view keys = search.states.Keys(written, size);
+  if (!Append(paths.keys, written * key_size, keys.data(), keys.size()) ||
+      !Append(paths.parents, written * sizeof(int32_t),
+          reinterpret_cast<const char*>(search.parents.data() + written),
+          (size - written) * sizeof(int32_t))) {
+    std::cerr << "Failed to write checkpoint (" << dir << ")!" << std::endl;
+    return false;
+  }
+  written = size;
+
+  const SearchStats &stats = search.stats;
+  const std::string temp_path = paths.header + ".tmp";
+  {
+    std::ofstream ofs(temp_path);
+    ofs << CHECKPOINT_HEADER << '\n'
+        << "level: " << layout << '\n'
+        << "states: " << size << '\n'
+        << "next: " << search.next << '\n'
+        << "layer-end: " << search.layer_end << '\n'
+        << "depth: " << search.depth << '\n'
+        << "generated: " << stats.generated << '\n'
+        << "inserted: " << stats.inserted << '\n'
+        << "goal-checks: " << stats.goal_checks << '\n'
+        << "seconds: " << seconds << '\n'
+        << "layers:";
+    for (const SearchStats::Layer &layer : stats.layers) ofs << ' ' << layer.states << ' ' << layer.seconds;
+    ofs << '\n';
+    if (!ofs.flush()) {
+      std::cerr << "Failed to write checkpoint (" << temp_path << ")!" << std::endl;
+      return false;
+    }
+  }
+  if (std::rename(temp_path.c_str(), paths.header.c_str()) != 0) {
+    std::cerr << "Failed to write checkpoint (" << paths.header << ")!" << std::endl;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,58 @@
+#ifndef CHECKPOINT_H_INCLUDED
+#define CHECKPOINT_H_INCLUDED
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "compact-search.h"
+#include "level.h"
+
+// Checkpoints of a breadth-first search over packed states (see
+// CompactSearch), which allow a long search to be resumed after a restart.
+//
+// A checkpoint directory contains three files:
+//
+//  - keys.bin: the keys of the visited states, back to back, in order of id.
+//  - parents.bin: the parent id of each state, as native 32-bit integers.
+//  - checkpoint.txt: the number of states in the checkpoint, the position of
+//    the search, its statistics and the layout of the level (see
+//    CanonicalLayout()) in a text format like that of the solution cache.
+//
+// Checkpoints are written between layers. Since states are only ever added,
+// only the states discovered since the previous checkpoint are appended to the
+// binary files, after which checkpoint.txt is replaced atomically. If the
+// process dies while appending, the extra data is ignored on resume.
+
+// Reads the checkpoint in `dir`, which must have been written for `level`.
+// Returns an empty optional (after printing an error message) on failure.
+std::optional<CompactSearch> ReadCheckpoint(const std::string &dir, const Level &level);
+
+class CheckpointWriter {
+public:
+  // Prepares to write checkpoints for `level` to `dir`, which is created if
+  // necessary. If `resumed` is true, `search` must have been read from the
+  // checkpoint in `dir` by ReadCheckpoint(), which is then extended. Otherwise,
+  // any existing checkpoint in `dir` is replaced. Returns an empty optional
+  // (after printing an error message) on failure.
+  static std::optional<CheckpointWriter> Create(
+      const std::string &dir, const Level &level, const CompactSearch &search, bool resumed);
+
+  // Writes a checkpoint of `search`, which must have been extended from the
+  // search previously written. `seconds` is the total search time so far.
+  // Returns false (after printing an error message) on failure.
+  bool Write(const CompactSearch &search, double seconds);
+
+private:
+  CheckpointWriter(std::string dir, std::string layout, size_t written) :
+      dir(std::move(dir)), layout(std::move(layout)), written(written) {}
+
+  std::string dir;
+  std::string layout;
+
+  // Number of states already in the binary files.
+  size_t written;
+};
+
+#endif  // ndef CHECKPOINT_H_INCLUDED
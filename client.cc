@@ -0,0 +1,123 @@
+// Command-line client for the solver daemon (see `solve --serve` and the
+// protocol description in server.h).
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool WriteAll(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    data.remove_prefix(n);
+  }
+  return true;
+}
+
+// Reads responses from the server, and prints them to standard output, until
+// `count` responses have been received. Returns false if the connection was
+// closed before that.
+bool ReadResponses(int fd, std::string &buffer, int count) {
+  char chunk[4096];
+  while (count > 0) {
+    size_t end = buffer.find("\n\n");
+    if (end != std::string::npos) {
+      std::cout << buffer.substr(0, end + 2) << std::flush;
+      buffer.erase(0, end + 2);
+      --count;
+      continue;
+    }
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n <= 0) return false;
+    buffer.append(chunk, n);
+  }
+  return true;
+}
+
+void PrintUsage() {
+  std::cout << "Usage: solve-client [--pipeline] <socket> <level.txt>...\n"
+      "\n"
+      "Sends each level to the solver daemon listening on <socket>, and prints\n"
+      "the responses. By default, each request waits for the previous response.\n"
+      "With --pipeline, all requests are sent at once, so that each request\n"
+      "cancels the one before it (like an editor sending a request per edit).\n"
+      << std::flush;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bool pipeline = false;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--pipeline") {
+      pipeline = true;
+    } else if (arg.starts_with("-")) {
+      PrintUsage();
+      return 1;
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+  if (args.size() < 2) {
+    PrintUsage();
+    return 1;
+  }
+  const std::string &socket_path = args[0];
+
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "Socket path too long (" << socket_path << ")!" << std::endl;
+    return 1;
+  }
+  strcpy(addr.sun_path, socket_path.c_str());
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+    std::cerr << "Failed to connect to " << socket_path << ": " << strerror(errno) << std::endl;
+    return 1;
+  }
+
+  std::string buffer;
+  int outstanding = 0;
+  for (size_t i = 1; i < args.size(); ++i) {
+    std::ifstream ifs(args[i]);
+    if (!ifs) {
+      std::cerr << "Failed to open input file (" << args[i] << ")!" << std::endl;
+      return 1;
+    }
+    std::ostringstream text;
+    text << ifs.rdbuf();
+    std::ostringstream request;
+    request << "solve " << i << ' ' << text.str().size() << '\n' << text.str();
+    if (!WriteAll(fd, request.str())) {
+      std::cerr << "Failed to send request!" << std::endl;
+      return 1;
+    }
+    ++outstanding;
+    if (!pipeline) {
+      if (!ReadResponses(fd, buffer, outstanding)) break;
+      outstanding = 0;
+    }
+  }
+  shutdown(fd, SHUT_WR);
+  if (outstanding > 0 && !ReadResponses(fd, buffer, outstanding)) {
+    std::cerr << "Connection closed unexpectedly!" << std::endl;
+    close(fd);
+    return 1;
+  }
+  close(fd);
+  return 0;
+}
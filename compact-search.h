@@ -0,0 +1,44 @@
+#ifndef COMPACT_SEARCH_H_INCLUDED
+#define COMPACT_SEARCH_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "search-stats.h"
+#include "state-set.h"
+
+// State of a breadth-first search in which visited levels are stored as packed
+// keys (see Level::Key()), which takes an order of magnitude less memory per
+// state than storing Level objects. Since keys do not depend on group
+// numbering, states that differ only in group numbering are merged too.
+//
+// Solve() uses this when the memory limit is reached, and from the start when
+// writing checkpoints (see checkpoint.h).
+struct CompactSearch {
+  explicit CompactSearch(int key_size) : states(key_size) {}
+
+  size_t MemoryUsage() const {
+    return states.MemoryUsage() + parents.capacity() * sizeof(parents[0]);
+  }
+
+  // Visited states, in breadth-first order.
+  StateSet states;
+
+  // Id of the state from which each state was reached (or -1 for the initial
+  // state).
+  std::vector<int32_t> parents;
+
+  // Id of the next state to expand, and the end of the layer it belongs to.
+  uint32_t next = 0;
+  uint32_t layer_end = 0;
+
+  // Depth of the state with id `next`.
+  int depth = 0;
+
+  // Statistics of the search so far, when searching with checkpoints (so that
+  // they can be restored with the search).
+  SearchStats stats;
+};
+
+#endif  // ndef COMPACT_SEARCH_H_INCLUDED
@@ -0,0 +1,72 @@
+#include "decompose.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "level.h"
+
+std::vector<Region> FindRegions(const Level &level) {
+  const int height = level.Height();
+  const int width = level.Width();
+  std::vector<int> region_of(height * width, -1);
+  std::vector<Region> regions;
+  std::vector<std::pair<int, int>> cells;
+  for (int r = 1; r + 1 < height; ++r) {
+    for (int c = 1; c + 1 < width; ++c) {
+      if (level.At(r, c).type == Cell::WALL || region_of[r * width + c] >= 0) continue;
+
+      // Flood fill the region, and find its bounding box.
+      const int index = regions.size();
+      int min_r = r, max_r = r, min_c = c, max_c = c;
+      bool movable = false;
+      cells.clear();
+      cells.push_back({r, c});
+      region_of[r * width + c] = index;
+      for (size_t i = 0; i < cells.size(); ++i) {
+        auto [r1, c1] = cells[i];
+        min_r = std::min(min_r, r1);
+        max_r = std::max(max_r, r1);
+        min_c = std::min(min_c, c1);
+        max_c = std::max(max_c, c1);
+        movable = movable || level.At(r1, c1).type == Cell::MOVABLE;
+        for (int d = 0; d < ND; ++d) {
+          int r2 = r1 + DR[d];
+          int c2 = c1 + DC[d];
+          if (level.At(r2, c2).type != Cell::WALL && region_of[r2 * width + c2] < 0) {
+            region_of[r2 * width + c2] = index;
+            cells.push_back({r2, c2});
+          }
+        }
+      }
+      if (!movable) {
+        // Keep the cells marked, but reuse the index.
+        for (auto [r1, c1] : cells) region_of[r1 * width + c1] = height * width;
+        continue;
+      }
+
+      std::vector<std::string> grid;
+      std::vector<Point> fixed;
+      for (int r1 = min_r; r1 <= max_r; ++r1) {
+        std::string row;
+        for (int c1 = min_c; c1 <= max_c; ++c1) {
+          const Cell &cell = level.At(r1, c1);
+          if (region_of[r1 * width + c1] != index) {
+            row += '#';
+          } else if (cell.type == Cell::MOVABLE) {
+            row += cell.Char();
+            if (cell.fixed) fixed.push_back(Point::Narrow(r1 - min_r + 1, c1 - min_c + 1));
+          } else {
+            row += '.';
+          }
+        }
+        grid.push_back(std::move(row));
+      }
+      Region region = {.level = Level(grid), .dr = min_r - 1, .dc = min_c - 1};
+      for (Point p : fixed) region.level.Fix(p);
+      regions.push_back(std::move(region));
+    }
+  }
+  return regions;
+}
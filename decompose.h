@@ -0,0 +1,30 @@
+#ifndef DECOMPOSE_H_INCLUDED
+#define DECOMPOSE_H_INCLUDED
+
+#include <vector>
+
+#include "level.h"
+
+// A part of a level that is separated from the rest of the level by walls.
+//
+// Blocks cannot pass through walls, so a block never leaves the region it
+// starts in, and moves in one region do not affect any other region. A level
+// that consists of several regions can therefore be solved by solving each
+// region on its own, and the length of a shortest solution is the sum of the
+// lengths for the regions (provided no color occurs in more than one region,
+// since such blocks can never connect).
+struct Region {
+  // The region as a level of its own: the bounding box of the region, with
+  // the cells of other regions turned into walls.
+  Level level;
+
+  // Offset of the grid of `level` within the grid of the original level.
+  int dr, dc;
+};
+
+// Returns the regions of the level that contain movable blocks, in row-major
+// order of their first cell: the connected components of cells that are not
+// walls.
+std::vector<Region> FindRegions(const Level &level);
+
+#endif  // ndef DECOMPOSE_H_INCLUDED
@@ -0,0 +1,102 @@
+#include "enumerate.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "level.h"
+#include "parallel.h"
+#include "state-set.h"
+
+namespace {
+
+// Number of states expanded by a thread at a time. Successors are collected per
+// chunk (rather than per thread) so the results are deterministic.
+const uint32_t CHUNK_SIZE = 256;
+
+struct Chunk {
+  // Concatenated keys of all successors of the states in this chunk.
+  std::string successors;
+
+  // For each state in this chunk: whether it is solved, and the number of
+  // successors it has (which is 0 for solved states).
+  std::vector<std::pair<bool, uint32_t>> expanded;
+
+  int64_t solved = 0;
+  int64_t dead_ends = 0;
+};
+
+}  // namespace
+
+Enumeration Enumerate(const Level &initial, const EnumerateOptions &options) {
+  Enumeration result(initial.KeySize());
+  StateSet &states = result.states;
+  const int key_size = states.KeySize();
+  bool record_edges = options.record_edges;
+  states.Insert(initial.Key());
+  if (record_edges) result.edge_begin.push_back(0);
+  uint32_t begin = 0;
+  while (begin < states.Size()) {
+    const uint32_t end = states.Size();
+    if (options.max_memory > 0 && result.MemoryUsage() > options.max_memory) {
+      if (record_edges) {
+        // Discard the edges and try to continue without them.
+        record_edges = false;
+        std::vector<uint32_t>().swap(result.edge_begin);
+        std::vector<uint32_t>().swap(result.edges);
+      }
+      if (result.MemoryUsage() > options.max_memory) {
+        result.complete = false;
+        break;
+      }
+    }
+    result.layer_begin.push_back(begin);
+
+    // Expand all states in the current layer in parallel. This only reads from
+    // `states`, which is safe to do concurrently.
+    std::vector<Chunk> chunks((end - begin + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    ParallelFor(chunks.size(), options.threads, [&](size_t i) {
+      Chunk &chunk = chunks[i];
+      uint32_t chunk_begin = begin + i * CHUNK_SIZE;
+      uint32_t chunk_end = std::min(chunk_begin + CHUNK_SIZE, end);
+      for (uint32_t id = chunk_begin; id < chunk_end; ++id) {
+        Level level = initial.FromKey(states.Key(id));
+        if (level.Solved()) {
+          ++chunk.solved;
+          chunk.expanded.push_back({true, 0});
+          continue;
+        }
+        std::vector<Level> successors = level.Successors();
+        if (successors.empty()) ++chunk.dead_ends;
+        for (const Level &next_level : successors) chunk.successors += next_level.Key();
+        chunk.expanded.push_back({false, successors.size()});
+      }
+    });
+
+    // Merge the successors into the set of visited states, which assigns ids
+    // to the states in the next layer.
+    EnumerateLayer &layer = result.layers.emplace_back();
+    layer.states = end - begin;
+    for (const Chunk &chunk : chunks) {
+      layer.solved += chunk.solved;
+      layer.dead_ends += chunk.dead_ends;
+      std::string_view keys = chunk.successors;
+      size_t pos = 0;
+      for (auto [solved, count] : chunk.expanded) {
+        result.solved.push_back(solved);
+        for (uint32_t j = 0; j < count; ++j, pos += key_size) {
+          uint32_t id = states.Insert(keys.substr(pos, key_size)).first;
+          if (record_edges) result.edges.push_back(id);
+        }
+        if (record_edges) result.edge_begin.push_back(result.edges.size());
+      }
+    }
+    begin = end;
+  }
+  result.layer_begin.push_back(begin);
+  result.has_edges = record_edges && result.complete;
+  return result;
+}
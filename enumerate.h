@@ -0,0 +1,79 @@
+#ifndef ENUMERATE_H_INCLUDED
+#define ENUMERATE_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "level.h"
+#include "state-set.h"
+
+// Statistics about a single layer of the state space, i.e., all states at the
+// same distance from the initial state.
+struct EnumerateLayer {
+  // Number of states in the layer.
+  int64_t states = 0;
+
+  // Number of states in the layer that are solved. These are not expanded,
+  // since the game ends when the level is solved.
+  int64_t solved = 0;
+
+  // Number of unsolved states in the layer that have no successors at all.
+  int64_t dead_ends = 0;
+};
+
+struct EnumerateOptions {
+  // Number of threads used to expand states.
+  int threads = 1;
+
+  // If true, the successor graph is recorded in Enumeration::edges.
+  bool record_edges = false;
+
+  // Approximate limit on the memory used for the enumeration, in bytes, or 0
+  // for no limit. When the limit is reached, recorded edges are discarded
+  // first; if the states alone exceed the limit, enumeration stops early.
+  size_t max_memory = 0;
+};
+
+struct Enumeration {
+  explicit Enumeration(int key_size) : states(key_size) {}
+
+  // All states reachable from the initial state, with ids assigned in
+  // breadth-first order (so the initial state has id 0).
+  StateSet states;
+
+  // States with ids in range [layer_begin[d], layer_begin[d + 1]) are at
+  // depth d. Contains one element more than `layers`.
+  std::vector<uint32_t> layer_begin;
+
+  // Statistics per layer. The last layer is the one furthest from the initial
+  // state, so layers.size() - 1 is the eccentricity of the initial state.
+  std::vector<EnumerateLayer> layers;
+
+  // solved[i] is true if the state with id i is solved.
+  std::vector<bool> solved;
+
+  // Successor graph in compressed sparse row format: the ids of the
+  // successors of state i are edges[edge_begin[i]..edge_begin[i + 1]).
+  // Only set if has_edges is true.
+  bool has_edges = false;
+  std::vector<uint32_t> edge_begin;
+  std::vector<uint32_t> edges;
+
+  // False if the enumeration was stopped early because the memory limit was
+  // reached, in which case the last layers are missing.
+  bool complete = true;
+
+  // Approximate number of bytes of memory used.
+  size_t MemoryUsage() const {
+    return states.MemoryUsage() + solved.capacity() / 8 +
+        (edge_begin.capacity() + edges.capacity()) * sizeof(uint32_t);
+  }
+};
+
+// Explores the complete state space reachable from the initial level, one
+// layer at a time. Expanding the states of a layer is split over multiple
+// threads; the results do not depend on the number of threads used.
+Enumeration Enumerate(const Level &initial, const EnumerateOptions &options);
+
+#endif  // ndef ENUMERATE_H_INCLUDED
@@ -0,0 +1,282 @@
+#include "heuristic.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "level.h"
+#include "parallel.h"
+
+namespace {
+
+// Distance stored for abstract states from which the goal cannot be reached.
+constexpr uint8_t UNREACHABLE = 255;
+
+// With only two components of a color, the distance in the abstraction is
+// just the gap between them minus one, which LowerBound() already gives.
+constexpr size_t MIN_PATTERN_COMPONENTS = 3;
+
+// Limit on the work needed to build a single table: the number of abstract
+// states times the number of moves per state. Colors with larger tables are
+// left out of the pattern database.
+constexpr size_t MAX_TABLE_WORK = size_t{1} << 26;
+
+// Returns whether the given column ranges are connected by gaps of at most one
+// column.
+bool Connected(const std::vector<int> &min_c, const std::vector<int> &widths) {
+  const size_t n = min_c.size();
+  std::vector<char> reached(n, char{false});
+  std::vector<size_t> todo = {0};
+  reached[0] = true;
+  size_t count = 1;
+  while (!todo.empty()) {
+    size_t i = todo.back();
+    todo.pop_back();
+    for (size_t j = 0; j < n; ++j) {
+      if (reached[j]) continue;
+      int gap = std::max({0,
+          min_c[j] - (min_c[i] + widths[i] - 1),
+          min_c[i] - (min_c[j] + widths[j] - 1)});
+      if (gap <= 1) {
+        reached[j] = true;
+        todo.push_back(j);
+        ++count;
+      }
+    }
+  }
+  return count == n;
+}
+
+// Returns the components of one color in the order used by pattern keys:
+// movable components first, then by width and position.
+std::vector<Component> SortForPattern(std::vector<Component> components) {
+  std::sort(components.begin(), components.end(), [](const Component &a, const Component &b) {
+    return std::make_tuple(a.fixed, a.max_c - a.min_c, a.min_c) <
+        std::make_tuple(b.fixed, b.max_c - b.min_c, b.min_c);
+  });
+  return components;
+}
+
+// Returns the key of the pattern of the given components (sorted by
+// SortForPattern()): for each component, its width, and its position plus one
+// if it is fixed or 0 otherwise, as bytes.
+std::string PatternKey(const std::vector<Component> &components) {
+  std::string key;
+  for (const Component &component : components) {
+    key += static_cast<char>(component.max_c - component.min_c + 1);
+    key += static_cast<char>(component.fixed ? component.min_c + 1 : 0);
+  }
+  return key;
+}
+
+// Returns, for each component, the column gap to the nearest other component
+// of the same color, or -1 if there is none.
+std::vector<int> NearestGaps(const std::vector<Component> &components) {
+  std::vector<int> gaps(components.size(), -1);
+  for (size_t i = 0; i < components.size(); ++i) {
+    for (size_t j = 0; j < components.size(); ++j) {
+      if (i == j || components[i].color != components[j].color) continue;
+      int gap = std::max({0,
+          components[j].min_c - components[i].max_c,
+          components[i].min_c - components[j].max_c});
+      if (gaps[i] < 0 || gap < gaps[i]) gaps[i] = gap;
+    }
+  }
+  return gaps;
+}
+
+}  // namespace
+
+std::vector<Component> FindComponents(const Level &level) {
+  std::vector<Component> components;
+  std::vector<char> visited(level.Height() * level.Width(), char{false});
+  std::vector<std::pair<int, int>> todo;
+  for (int r = 1; r + 1 < level.Height(); ++r) {
+    for (int c = 1; c + 1 < level.Width(); ++c) {
+      const Cell &cell = level.At(r, c);
+      if (cell.type != Cell::MOVABLE || cell.color == 0 || visited[r * level.Width() + c]) continue;
+      Component component = {.color = cell.color, .min_c = c, .max_c = c, .fixed = false};
+      visited[r * level.Width() + c] = true;
+      todo.push_back({r, c});
+      while (!todo.empty()) {
+        auto [r1, c1] = todo.back();
+        todo.pop_back();
+        component.min_c = std::min(component.min_c, c1);
+        component.max_c = std::max(component.max_c, c1);
+        component.fixed = component.fixed || level.At(r1, c1).fixed;
+        for (int d = 0; d < ND; ++d) {
+          int r2 = r1 + DR[d];
+          int c2 = c1 + DC[d];
+          const Cell &next = level.At(r2, c2);
+          if (next.type == Cell::MOVABLE && next.color == cell.color && !visited[r2 * level.Width() + c2]) {
+            visited[r2 * level.Width() + c2] = true;
+            todo.push_back({r2, c2});
+          }
+        }
+      }
+      components.push_back(component);
+    }
+  }
+  return components;
+}
+
+struct PatternDatabase::Table {
+  // For each component (in pattern order): its lowest position (min_c), the
+  // number of positions, and the stride in the distance table.
+  std::vector<int> low;
+  std::vector<int> positions;
+  std::vector<size_t> strides;
+
+  // Distance to the abstract goal by index, where the index is the sum of
+  // (min_c - low) * stride over the components.
+  std::vector<uint8_t> distance;
+
+  size_t Index(const std::vector<Component> &components) const {
+    size_t index = 0;
+    for (size_t i = 0; i < components.size(); ++i) {
+      index += (components[i].min_c - low[i]) * strides[i];
+    }
+    return index;
+  }
+};
+
+PatternDatabase::PatternDatabase(const Level &initial_level, int threads) : width(initial_level.Width()) {
+  std::map<int, std::vector<Component>> by_color;
+  for (const Component &component : FindComponents(initial_level)) {
+    by_color[component.color].push_back(component);
+  }
+  std::vector<std::string> patterns;
+  for (auto &[color, components] : by_color) {
+    if (components.size() >= MIN_PATTERN_COMPONENTS) {
+      patterns.push_back(PatternKey(SortForPattern(components)));
+    }
+  }
+  ParallelFor(patterns.size(), threads, [&](size_t i) { GetTable(patterns[i]); });
+  // Components never split, so no later state needs a table either.
+  unused = patterns.empty();
+}
+
+int PatternDatabase::LowerBound(const std::vector<Component> &components) const {
+  if (unused) return 0;
+  std::map<int, std::vector<Component>> by_color;
+  for (const Component &component : components) by_color[component.color].push_back(component);
+  int bound = 0;
+  for (auto &[color, color_components] : by_color) {
+    if (color_components.size() < MIN_PATTERN_COMPONENTS) continue;
+    std::vector<Component> sorted = SortForPattern(std::move(color_components));
+    std::shared_ptr<const Table> table = GetTable(PatternKey(sorted));
+    if (table) bound = std::max<int>(bound, table->distance[table->Index(sorted)]);
+  }
+  return bound;
+}
+
+size_t PatternDatabase::MemoryUsage() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return memory_usage;
+}
+
+std::shared_ptr<const PatternDatabase::Table> PatternDatabase::GetTable(const std::string &pattern) const {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(pattern);
+    if (it != tables.end()) return it->second;
+  }
+
+  // Building a table takes about size * 2^(n + 1) steps (every state, in both
+  // directions, with every subset of the n components). Patterns for which
+  // that exceeds MAX_TABLE_WORK get no table; the size is checked after each
+  // multiplication, so it cannot overflow.
+  const size_t n = pattern.size() / 2;
+  const size_t subset_work = size_t{2} << std::min<size_t>(n, 32);
+  const size_t max_size = subset_work > MAX_TABLE_WORK ? 0 : MAX_TABLE_WORK / subset_work;
+  auto table = std::make_shared<Table>();
+  std::vector<int> widths;
+  uint64_t movable = 0;
+  size_t size = 1;
+  for (size_t i = 0; i < n && size <= max_size; ++i) {
+    const int component_width = pattern[2 * i];
+    const int fixed_position = pattern[2 * i + 1];
+    widths.push_back(component_width);
+    table->low.push_back(fixed_position > 0 ? fixed_position - 1 : 1);
+    table->positions.push_back(fixed_position > 0 ? 1 : std::max(1, width - 1 - component_width));
+    table->strides.push_back(size);
+    size *= table->positions.back();
+    if (fixed_position == 0) movable |= uint64_t{1} << i;
+  }
+  if (size > max_size) {
+    table = nullptr;
+  } else {
+    // Breadth-first search backwards from all goal states. Moves are
+    // reversible, so the neighbors are the same in both directions.
+    table->distance.assign(size, UNREACHABLE);
+    std::vector<uint32_t> queue;
+    std::vector<int> min_c(n);
+    auto decode = [&](size_t index) {
+      for (size_t i = 0; i < n; ++i) {
+        min_c[i] = table->low[i] + index / table->strides[i] % table->positions[i];
+      }
+    };
+    for (size_t index = 0; index < size; ++index) {
+      decode(index);
+      if (Connected(min_c, widths)) {
+        table->distance[index] = 0;
+        queue.push_back(index);
+      }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+      const size_t index = queue[head];
+      const uint8_t next_distance = std::min(table->distance[index] + 1, UNREACHABLE - 1);
+      decode(index);
+      for (int dc : {-1, +1}) {
+        for (uint64_t subset = movable; subset != 0; subset = (subset - 1) & movable) {
+          ptrdiff_t offset = 0;
+          bool valid = true;
+          for (size_t i = 0; i < n && valid; ++i) {
+            if ((subset & (uint64_t{1} << i)) == 0) continue;
+            int c = min_c[i] + dc - table->low[i];
+            valid = c >= 0 && c < table->positions[i];
+            offset += dc * ptrdiff_t(table->strides[i]);
+          }
+          if (!valid) continue;
+          const size_t next = index + offset;
+          if (table->distance[next] == UNREACHABLE) {
+            table->distance[next] = next_distance;
+            queue.push_back(next);
+          }
+        }
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto [it, inserted] = tables.emplace(pattern, std::move(table));
+  if (inserted && it->second) memory_usage += it->second->distance.capacity();
+  return it->second;
+}
+
+HeuristicValues EvaluateHeuristics(const Level &level, const PatternDatabase *pdb) {
+  HeuristicValues values;
+  std::vector<Component> components = FindComponents(level);
+  for (int gap : NearestGaps(components)) {
+    if (gap < 0) continue;  // the only component of its color
+    values.lower_bound = std::max({values.lower_bound, 1, gap - 1});
+    values.estimate += 1 + std::max(0, gap - 1);
+  }
+  if (pdb != nullptr) values.lower_bound = std::max(values.lower_bound, pdb->LowerBound(components));
+  return values;
+}
+
+int LowerBound(const Level &level) {
+  return EvaluateHeuristics(level).lower_bound;
+}
+
+int EstimateDistance(const Level &level) {
+  return EvaluateHeuristics(level).estimate;
+}
@@ -0,0 +1,109 @@
+#ifndef HEURISTIC_H_INCLUDED
+#define HEURISTIC_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "level.h"
+
+// Heuristics for informed search (see best-first.h).
+//
+// All are based on the components of equally-colored blocks, which must all
+// merge into a single component per color. Components never split, and a move
+// shifts blocks by a single column (gravity only moves them vertically), so
+// the gap between the columns spanned by two components shrinks by at most one
+// per move. Two components can only touch when that gap is at most one.
+
+// A connected component of blocks of the same (non-black) color.
+struct Component {
+  int color;
+
+  // Range of columns spanned by the component (inclusive). Since components
+  // are connected, they occupy every column in between.
+  int min_c, max_c;
+
+  // Whether the component is attached to a wall, and can never move.
+  bool fixed;
+};
+
+// Returns the components of the level, in row-major order of their first cell.
+std::vector<Component> FindComponents(const Level &level);
+
+// Pattern databases, which give a stronger lower bound than LowerBound() for
+// levels with several components of the same color.
+//
+// The level is abstracted to the column ranges of the components of a single
+// color. In the abstraction, a move shifts any subset of the components that
+// are not fixed by one column in the same direction (a real move may push
+// several groups along), and the abstract goal is reached when the components
+// are connected by gaps of at most one column. The distance to the goal is
+// computed for every abstract state by a breadth-first search backwards from
+// the goal states (moves are reversible), and stored in a table with one byte
+// per state.
+//
+// Since a real move changes each abstract state by at most one abstract move,
+// and merging components only constrains the abstraction further, the
+// distances are consistent lower bounds. Colors are not additive (one move can
+// shift components of several colors), so the maximum over colors is used.
+//
+// Tables depend only on the width of the level and the widths (and positions,
+// if fixed) of the components, so one database serves every state of a level.
+// Tables for the initial level are built when the database is created, in
+// parallel; tables for components that merge during the search are built when
+// first needed. All methods are thread-safe.
+class PatternDatabase {
+public:
+  PatternDatabase(const Level &initial_level, int threads);
+
+  // Returns the lower bound for the level with the given components.
+  int LowerBound(const std::vector<Component> &components) const;
+
+  // Approximate number of bytes of memory used by the tables.
+  size_t MemoryUsage() const;
+
+private:
+  struct Table;
+
+  // Returns the table for the given pattern (see PatternKey() in the .cc),
+  // building it if necessary, or null if it would be too large.
+  std::shared_ptr<const Table> GetTable(const std::string &pattern) const;
+
+  // Width of the level, including padding walls on the left and right.
+  int width;
+
+  // Whether no color has enough components to need a table.
+  bool unused;
+
+  mutable std::mutex mutex;
+  mutable std::map<std::string, std::shared_ptr<const Table>> tables;
+  mutable size_t memory_usage = 0;
+};
+
+// Returns a lower bound on the number of moves needed to solve the level: for
+// each component, the gap to the nearest other component of the same color,
+// minus one, and at least one move if the level is not solved. The bound is
+// consistent: it changes by at most one per move.
+int LowerBound(const Level &level);
+
+// Returns an estimate of the number of moves needed to solve the level, which
+// is not a lower bound, but discriminates better between states: the number
+// of components that must merge, plus the gaps of all components to their
+// nearest partners.
+int EstimateDistance(const Level &level);
+
+struct HeuristicValues {
+  int lower_bound = 0;
+  int estimate = 0;
+};
+
+// Returns both LowerBound() and EstimateDistance(), which is faster than
+// calling them separately. If `pdb` is not null, the lower bound is raised to
+// that of the pattern database, if it is higher.
+HeuristicValues EvaluateHeuristics(const Level &level, const PatternDatabase *pdb = nullptr);
+
+#endif  // ndef HEURISTIC_H_INCLUDED
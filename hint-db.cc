@@ -0,0 +1,306 @@
+#include "hint-db.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "enumerate.h"
+#include "level.h"
+#include "parallel.h"
+#include "state-set.h"
+
+namespace {
+
+// Number of states processed by a thread at a time.
+const size_t CHUNK_SIZE = 1024;
+
+// Distance of states that have not been labeled (yet). Any states that are
+// still unlabeled after the backward search are unsolvable.
+const uint16_t UNLABELED = HINT_DB_UNSOLVABLE;
+
+// Largest distance that can be stored.
+const uint16_t MAX_DISTANCE = HINT_DB_UNSOLVABLE - 1;
+
+uint16_t LoadDistance(std::vector<uint16_t> &dist, uint32_t id) {
+  return std::atomic_ref<uint16_t>(dist[id]).load(std::memory_order_relaxed);
+}
+
+// Labels states using a breadth-first search from the solved states over the
+// reversed edges of the successor graph. Frees the forward edges.
+void LabelWithEdges(Enumeration &enumeration, std::vector<uint16_t> &dist, int threads) {
+  const uint32_t n = enumeration.states.Size();
+
+  // Construct predecessor lists in compressed sparse row format.
+  std::vector<uint32_t> pred_begin(n + 1, 0);
+  for (uint32_t id : enumeration.edges) ++pred_begin[id + 1];
+  for (uint32_t i = 0; i < n; ++i) pred_begin[i + 1] += pred_begin[i];
+  std::vector<uint32_t> preds(enumeration.edges.size());
+  {
+    std::vector<uint32_t> pos(pred_begin.begin(), pred_begin.end() - 1);
+    for (uint32_t i = 0; i < n; ++i) {
+      for (uint32_t j = enumeration.edge_begin[i]; j < enumeration.edge_begin[i + 1]; ++j) {
+        preds[pos[enumeration.edges[j]]++] = i;
+      }
+    }
+  }
+  std::vector<uint32_t>().swap(enumeration.edge_begin);
+  std::vector<uint32_t>().swap(enumeration.edges);
+
+  std::vector<uint32_t> frontier;
+  for (uint32_t i = 0; i < n; ++i) {
+    if (enumeration.solved[i]) {
+      dist[i] = 0;
+      frontier.push_back(i);
+    }
+  }
+  for (uint16_t d = 1; !frontier.empty() && d <= MAX_DISTANCE; ++d) {
+    std::vector<std::vector<uint32_t>> next((frontier.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    ParallelFor(next.size(), threads, [&](size_t c) {
+      size_t end = std::min(frontier.size(), (c + 1) * CHUNK_SIZE);
+      for (size_t k = c * CHUNK_SIZE; k < end; ++k) {
+        uint32_t v = frontier[k];
+        for (uint32_t j = pred_begin[v]; j < pred_begin[v + 1]; ++j) {
+          uint32_t u = preds[j];
+          uint16_t expected = UNLABELED;
+          if (std::atomic_ref<uint16_t>(dist[u]).compare_exchange_strong(
+                expected, d, std::memory_order_relaxed)) {
+            next[c].push_back(u);
+          }
+        }
+      }
+    });
+    frontier.clear();
+    for (const auto &v : next) frontier.insert(frontier.end(), v.begin(), v.end());
+  }
+}
+
+// Labels states without storing the successor graph, by recomputing the
+// successors of all unlabeled states in each round. A state is at distance d if
+// one of its successors is at distance d - 1.
+void LabelWithoutEdges(
+    const Level &initial, const Enumeration &enumeration,
+    std::vector<uint16_t> &dist, int threads) {
+  const uint32_t n = enumeration.states.Size();
+  for (uint32_t i = 0; i < n; ++i) {
+    if (enumeration.solved[i]) dist[i] = 0;
+  }
+  for (uint16_t d = 1; d <= MAX_DISTANCE; ++d) {
+    std::atomic<bool> changed = false;
+    ParallelFor((n + CHUNK_SIZE - 1) / CHUNK_SIZE, threads, [&](size_t c) {
+      uint32_t end = std::min<size_t>(n, (c + 1) * CHUNK_SIZE);
+      for (uint32_t u = c * CHUNK_SIZE; u < end; ++u) {
+        if (LoadDistance(dist, u) != UNLABELED) continue;
+        Level level = initial.FromKey(enumeration.states.Key(u));
+        for (const Level &next_level : level.Successors()) {
+          std::optional<uint32_t> v = enumeration.states.Find(next_level.Key());
+          assert(v);
+          if (LoadDistance(dist, *v) == d - 1) {
+            std::atomic_ref<uint16_t>(dist[u]).store(d, std::memory_order_relaxed);
+            changed = true;
+            break;
+          }
+        }
+      }
+    });
+    if (!changed) break;
+  }
+}
+
+bool WriteHintDatabase(
+    const Level &initial, const StateSet &states, const std::vector<uint16_t> &dist,
+    const HintDbStats &stats, const std::string &path) {
+  HintDbHeader header;
+  memcpy(header.magic, HINT_DB_MAGIC, sizeof(header.magic));
+  header.version = HINT_DB_VERSION;
+  header.width = initial.Width();
+  header.height = initial.Height();
+  header.key_size = states.KeySize();
+  header.state_count = stats.states;
+  header.solvable_count = stats.solvable;
+  header.table_size = 16;
+  while (header.table_size < 2 * header.state_count) header.table_size *= 2;
+  header.record_size = header.key_size + 2;
+  header.max_distance = stats.max_distance;
+
+  const uint32_t NO_STATE = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> slots(header.table_size, NO_STATE);
+  const uint64_t mask = header.table_size - 1;
+  for (uint32_t id = 0; id < states.Size(); ++id) {
+    uint64_t i = HashKey(states.Key(id)) & mask;
+    while (slots[i] != NO_STATE) i = (i + 1) & mask;
+    slots[i] = id;
+  }
+
+  // Write to a temporary file first, so that readers never observe a
+  // partially-written database.
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream ofs(temp_path, std::ios::binary);
+    if (!ofs) {
+      std::cerr << "Failed to open output file (" << temp_path << ")!" << std::endl;
+      return false;
+    }
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::string walls = initial.Walls();
+    ofs.write(walls.data(), walls.size());
+    const std::string empty_key(header.key_size, '\0');
+    for (uint32_t id : slots) {
+      std::string_view key = id == NO_STATE ? empty_key : states.Key(id);
+      uint16_t d = id == NO_STATE ? HINT_DB_EMPTY : dist[id];
+      ofs.write(key.data(), key.size());
+      ofs.write(reinterpret_cast<const char*>(&d), sizeof(d));
+    }
+    if (!ofs.flush()) {
+      std::cerr << "Failed to write output file (" << temp_path << ")!" << std::endl;
+      return false;
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::cerr << "Failed to rename " << temp_path << " to " << path << "!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+std::optional<HintDbStats> BuildHintDatabase(
+    const Level &initial, const HintDbOptions &options, const std::string &path) {
+  Enumeration enumeration = Enumerate(initial, {
+      .threads = options.threads,
+      .record_edges = true,
+      .max_memory = options.max_memory});
+  if (!enumeration.complete) {
+    std::cerr << "Memory limit exceeded after enumerating "
+        << enumeration.states.Size() << " states!" << std::endl;
+    return {};
+  }
+
+  const uint32_t n = enumeration.states.Size();
+  HintDbStats stats;
+  stats.states = n;
+
+  // Reversing the edges temporarily requires about as much memory as the
+  // edges themselves.
+  size_t reverse_size = (n + 1 + enumeration.edges.size()) * sizeof(uint32_t);
+  stats.used_edges = enumeration.has_edges && (options.max_memory == 0 ||
+      enumeration.MemoryUsage() + reverse_size <= options.max_memory);
+  std::vector<uint16_t> dist(n, UNLABELED);
+  if (stats.used_edges) {
+    LabelWithEdges(enumeration, dist, options.threads);
+  } else {
+    std::vector<uint32_t>().swap(enumeration.edge_begin);
+    std::vector<uint32_t>().swap(enumeration.edges);
+    LabelWithoutEdges(initial, enumeration, dist, options.threads);
+  }
+
+  for (uint16_t d : dist) {
+    if (d != UNLABELED) {
+      ++stats.solvable;
+      stats.max_distance = std::max<uint32_t>(stats.max_distance, d);
+    }
+  }
+  if (stats.max_distance == MAX_DISTANCE) {
+    std::cerr << "Maximum distance exceeded!" << std::endl;
+    return {};
+  }
+  stats.initial_distance = dist[0];
+  if (!WriteHintDatabase(initial, enumeration.states, dist, stats, path)) return {};
+  return stats;
+}
+
+std::optional<HintDatabase> HintDatabase::Open(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Failed to open hint database (" << path << ")!" << std::endl;
+    return {};
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < sizeof(HintDbHeader)) {
+    std::cerr << "Invalid hint database (" << path << ")!" << std::endl;
+    close(fd);
+    return {};
+  }
+  size_t size = st.st_size;
+  void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    std::cerr << "Failed to map hint database (" << path << ")!" << std::endl;
+    return {};
+  }
+  const HintDbHeader &h = *static_cast<const HintDbHeader*>(data);
+  if (memcmp(h.magic, HINT_DB_MAGIC, sizeof(h.magic)) != 0 ||
+      h.version != HINT_DB_VERSION ||
+      h.record_size != h.key_size + 2 ||
+      h.table_size == 0 || (h.table_size & (h.table_size - 1)) != 0 ||
+      size != sizeof(HintDbHeader) + uint64_t{h.width} * h.height + h.table_size * h.record_size) {
+    std::cerr << "Invalid hint database (" << path << ")!" << std::endl;
+    munmap(data, size);
+    return {};
+  }
+  return HintDatabase(static_cast<const char*>(data), size);
+}
+
+HintDatabase::HintDatabase(const char *data, size_t size)
+    : data(data), size(size),
+      header(reinterpret_cast<const HintDbHeader*>(data)),
+      walls(data + sizeof(HintDbHeader), header->width * header->height),
+      table(walls.data() + walls.size()) {}
+
+HintDatabase::HintDatabase(HintDatabase &&other)
+    : data(other.data), size(other.size), header(other.header),
+      walls(other.walls), table(other.table) {
+  other.data = nullptr;
+}
+
+HintDatabase::~HintDatabase() {
+  if (data != nullptr) munmap(const_cast<char*>(data), size);
+}
+
+bool HintDatabase::Matches(const Level &level) const {
+  return level.Width() == header->width && level.Height() == header->height &&
+      level.Walls() == walls;
+}
+
+std::optional<uint16_t> HintDatabase::Lookup(std::string_view key) const {
+  assert(key.size() == header->key_size);
+  const uint64_t mask = header->table_size - 1;
+  for (uint64_t i = HashKey(key) & mask; ; i = (i + 1) & mask) {
+    const char *record = table + i * header->record_size;
+    uint16_t d;
+    memcpy(&d, record + header->key_size, sizeof(d));
+    if (d == HINT_DB_EMPTY) return {};
+    if (memcmp(record, key.data(), key.size()) == 0) return d;
+  }
+}
+
+std::optional<Hint> HintDatabase::Query(const Level &level) const {
+  if (!Matches(level)) return {};
+  std::optional<uint16_t> d = Lookup(level.Key());
+  if (!d) return {};
+  Hint hint = {.distance = *d, .move = {}};
+  if (*d == 0 || *d == HINT_DB_UNSOLVABLE) return hint;
+  for (const auto &[move, next_level] : level.Moves()) {
+    if (Lookup(next_level.Key()) == *d - 1) {
+      hint.move = move;
+      break;
+    }
+  }
+  assert(hint.move);
+  return hint;
+}
@@ -0,0 +1,148 @@
+#ifndef HINT_DB_H_INCLUDED
+#define HINT_DB_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "level.h"
+
+// A hint database stores, for every state reachable from the initial state of
+// a level, the minimum number of moves needed to reach a solved state.
+//
+// File format (all integers are stored in native byte order):
+//
+//  1. A HintDbHeader.
+//  2. The walls of the level: `height` times `width` bytes, as returned by
+//     Level::Walls(). Used to check that a queried state belongs to the level.
+//  3. A hash table of `table_size` records of `record_size` bytes each. Each
+//     record consists of a key (see Level::Key()) followed by a 16-bit
+//     distance. The table uses open addressing with linear probing, starting
+//     at slot HashKey(key) & (table_size - 1), and is at most half full.
+//
+// Distances are either the number of moves to reach a solved state (0 for
+// solved states), HINT_DB_UNSOLVABLE for states from which no solved state can
+// be reached, or HINT_DB_EMPTY for unused slots (whose keys are all zero).
+
+const char HINT_DB_MAGIC[8] = {'J', 'E', 'L', 'L', 'Y', 'H', 'D', 'B'};
+const uint32_t HINT_DB_VERSION = 1;
+const uint16_t HINT_DB_UNSOLVABLE = 0xfffe;
+const uint16_t HINT_DB_EMPTY = 0xffff;
+
+struct HintDbHeader {
+  char magic[8];
+  uint32_t version;
+
+  // Dimensions of the level, including padding (see Level::Width() and
+  // Level::Height()).
+  uint32_t width;
+  uint32_t height;
+
+  // Size of keys (see Level::KeySize()).
+  uint32_t key_size;
+
+  // Number of states stored in the table.
+  uint64_t state_count;
+
+  // Number of states from which a solved state can be reached.
+  uint64_t solvable_count;
+
+  // Number of slots in the table. Always a power of 2.
+  uint64_t table_size;
+
+  // Size of a record in the table: key_size + 2.
+  uint32_t record_size;
+
+  // Maximum distance of any solvable state.
+  uint32_t max_distance;
+};
+
+struct HintDbOptions {
+  // Number of threads used to build the database.
+  int threads = 1;
+
+  // Approximate limit on memory use in bytes, or 0 for no limit. If the
+  // successor graph doesn't fit, successors are recomputed instead, which is
+  // slower but only requires memory for the states themselves.
+  size_t max_memory = 0;
+};
+
+struct HintDbStats {
+  uint64_t states = 0;
+  uint64_t solvable = 0;
+  uint32_t max_distance = 0;
+
+  // Distance of the initial state, or HINT_DB_UNSOLVABLE.
+  uint16_t initial_distance = 0;
+
+  // Whether the successor graph was kept in memory.
+  bool used_edges = false;
+};
+
+// The answer to a hint query.
+struct Hint {
+  // Minimum number of moves needed to solve the level, or HINT_DB_UNSOLVABLE.
+  uint16_t distance;
+
+  // A move that brings the level one step closer to being solved. Only set if
+  // distance is neither 0 nor HINT_DB_UNSOLVABLE.
+  std::optional<Move> move;
+};
+
+// Read-only view of a hint database file.
+//
+// The file is memory-mapped rather than read, so opening a database is cheap
+// regardless of its size, and the pages are shared (through the page cache)
+// between all processes that use the same file. A query only touches the
+// hash table slots of the state and its successors.
+//
+// Queries may be executed concurrently from multiple threads.
+class HintDatabase {
+public:
+  // Maps the database file at the given path into memory. Returns an empty
+  // optional (after printing an error message) if the file cannot be opened or
+  // is not a valid hint database.
+  static std::optional<HintDatabase> Open(const std::string &path);
+
+  HintDatabase(HintDatabase &&other);
+  HintDatabase(const HintDatabase &) = delete;
+  HintDatabase &operator=(const HintDatabase &) = delete;
+  HintDatabase &operator=(HintDatabase &&) = delete;
+
+  ~HintDatabase();
+
+  const HintDbHeader &Header() const {
+    return *header;
+  }
+
+  // Returns true if the level has the same dimensions and walls as the level
+  // that the database was built for.
+  bool Matches(const Level &level) const;
+
+  // Returns the distance stored for a key, or an empty optional if the key is
+  // not in the database (i.e., the state is not reachable from the initial
+  // state of the level).
+  std::optional<uint16_t> Lookup(std::string_view key) const;
+
+  // Returns the hint for the given state, or an empty optional if the state is
+  // not in the database.
+  std::optional<Hint> Query(const Level &level) const;
+
+private:
+  HintDatabase(const char *data, size_t size);
+
+  const char *data;
+  size_t size;
+  const HintDbHeader *header;
+  std::string_view walls;
+  const char *table;
+};
+
+// Builds the hint database for the given level and writes it to `path`.
+// Returns an empty optional (after printing an error message) on failure.
+std::optional<HintDbStats> BuildHintDatabase(
+    const Level &initial, const HintDbOptions &options, const std::string &path);
+
+#endif  // ndef HINT_DB_H_INCLUDED
@@ -0,0 +1,375 @@
+#include "ida-star.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "heuristic.h"
+#include "level.h"
+#include "search.h"
+#include "search-monitor.h"
+#include "transposition-table.h"
+
+namespace {
+
+// Number of subtrees per thread into which the top of the search tree is
+// split before each iteration.
+constexpr size_t INITIAL_SUBTREES_PER_THREAD = 8;
+
+// Subtrees are only handed out to idle threads if their roots are at least
+// this many moves below the bound, so that each is worth the overhead.
+constexpr int MIN_SHARED_HEIGHT = 4;
+
+// Size of the transposition table if there is no memory limit.
+constexpr size_t DEFAULT_TABLE_MEMORY = size_t{64} << 20;
+
+// Number of locks guarding the transposition table, when it is shared by
+// several threads.
+constexpr size_t TABLE_LOCKS = 1024;
+
+constexpr int NO_BOUND = std::numeric_limits<int>::max();
+
+using Successors = std::vector<std::pair<Level, std::optional<Move>>>;
+
+class IdaStar {
+public:
+  IdaStar(const Level &initial_level, const SolveOptions &options);
+
+  SolveResult Run();
+
+private:
+  // The root of a subtree, or a state on the path to one, which is kept to
+  // reconstruct the solution.
+  struct Node {
+    Level level;
+
+    // Id of the node from which this one was reached (its index in `nodes`),
+    // or -1 for the initial level.
+    int32_t parent;
+
+    int depth;
+
+    // The move back to the parent, if any (see Level::SuccessorsExcept()).
+    std::optional<Move> undo;
+  };
+
+  // A state on the path of a depth-first search.
+  struct PathEntry {
+    Level level;
+    std::optional<Move> undo;
+  };
+
+  struct Worker {
+    explicit Worker(const SolveOptions &options) : options(options), monitor(this->options) {}
+
+    // Options for `monitor`. Only the first worker, which runs on the calling
+    // thread, reports progress.
+    SolveOptions options;
+    SearchMonitor monitor;
+
+    // Ids of the nodes at the roots of subtrees still to be searched. Guarded
+    // by IdaStar::mutex.
+    std::deque<int32_t> tasks;
+
+    // Smallest f beyond the bound seen in this iteration.
+    int next_bound = NO_BOUND;
+
+    int64_t expanded = 0;
+  };
+
+  int Heuristic(const Level &level) const {
+    return EvaluateHeuristics(level, pdb ? &*pdb : nullptr).lower_bound;
+  }
+
+  // Expands the top of the search tree into subtrees for the workers.
+  void Split();
+
+  // Searches subtrees until there are none left, or the search stops.
+  void Work(int t);
+
+  // Removes a task from the back of the worker's own queue, or else from the
+  // front of another's. Must be called with `mutex` held.
+  std::optional<int32_t> TakeTask(int t);
+
+  // Searches the subtree below path.back(), where path[0] is node `root`, at
+  // depth `root_depth`.
+  void Search(int t, int32_t root, int root_depth, std::vector<PathEntry> &path);
+
+  // Hands out successors[k..] of path.back() as new subtrees, if threads are
+  // waiting for work. Returns false (and does nothing) if not.
+  bool Share(int t, int32_t root, const std::vector<PathEntry> &path, Successors &successors, size_t k);
+
+  // Adds the states on `path` below its root (node `root`) to `nodes`, and
+  // returns the id of the last one. Must be called with `mutex` held.
+  int32_t AddPath(int32_t root, const std::vector<PathEntry> &path);
+
+  // Records the solution that ends at path.back() (or at node `root`, if
+  // `path` is empty), and stops the search.
+  void Found(int32_t root, const std::vector<PathEntry> &path);
+
+  // Stops the search with the given status.
+  void Abort(SolveStatus status);
+
+  const Level &initial_level;
+  const int threads;
+  std::optional<PatternDatabase> pdb;
+  std::vector<std::unique_ptr<Worker>> workers;
+
+  // Shared by all threads, so that each state is searched by one thread only
+  // (as far as the table remembers).
+  std::optional<TranspositionTable> table;
+
+  // Bound on f in the current iteration.
+  int bound = 0;
+
+  // Set when the search must stop, after a solution was found or the search
+  // was aborted.
+  std::atomic<bool> stop = false;
+
+  // Number of threads waiting for work, and number of tasks in the queues.
+  // Busy threads compare them (without locking) to decide whether to share.
+  std::atomic<int> idle = 0;
+  std::atomic<int> queued = 0;
+
+  // Guards the members below, and the tasks of the workers.
+  std::mutex mutex;
+  std::condition_variable work_cv;
+  std::deque<Node> nodes;
+
+  // Number of subtrees that have not been searched completely.
+  size_t pending = 0;
+
+  std::vector<Level> solution;
+  std::optional<SolveStatus> abort_status;
+};
+
+IdaStar::IdaStar(const Level &initial_level, const SolveOptions &options) :
+    initial_level(initial_level), threads(std::max(options.threads, 1)) {
+  if (options.pattern_database) pdb.emplace(initial_level, threads);
+  size_t table_memory = DEFAULT_TABLE_MEMORY;
+  if (options.max_memory > 0) {
+    table_memory = options.max_memory - std::min(options.max_memory, pdb ? pdb->MemoryUsage() : 0);
+  }
+  table.emplace(initial_level.KeySize(), table_memory / TranspositionTable::SlotSize(initial_level.KeySize()),
+      threads > 1 ? TABLE_LOCKS : 0);
+  for (int t = 0; t < threads; ++t) {
+    SolveOptions worker_options = options;
+    if (t > 0) worker_options.progress = nullptr;
+    workers.push_back(std::make_unique<Worker>(worker_options));
+  }
+}
+
+SolveResult IdaStar::Run() {
+  SolveResult result;
+  result.strategy = SearchStrategy::IDA_STAR;
+  if (initial_level.Solved()) {
+    result.status = SolveStatus::SOLVED;
+    result.steps.push_back(initial_level);
+    return result;
+  }
+  for (bound = Heuristic(initial_level); bound != NO_BOUND; ) {
+    result.lower_bound = bound;
+    table->NextIteration();
+    for (auto &worker : workers) worker->next_bound = NO_BOUND;
+    Split();
+    if (!stop) {
+      std::vector<std::thread> helpers;
+      for (int t = 1; t < threads; ++t) helpers.emplace_back([this, t]() { Work(t); });
+      Work(0);
+      for (std::thread &helper : helpers) helper.join();
+    }
+    if (stop) break;
+    int next_bound = NO_BOUND;
+    for (const auto &worker : workers) next_bound = std::min(next_bound, worker->next_bound);
+    bound = next_bound;
+  }
+  for (const auto &worker : workers) result.expanded += worker->expanded;
+  if (!solution.empty()) {
+    result.status = SolveStatus::SOLVED;
+    result.steps = std::move(solution);
+  } else if (abort_status) {
+    result.status = *abort_status;
+  } else {
+    // No state exceeded the bound, so every reachable state was expanded.
+    result.status = SolveStatus::UNSOLVABLE;
+  }
+  return result;
+}
+
+void IdaStar::Split() {
+  nodes.clear();
+  nodes.push_back({.level = initial_level, .parent = -1, .depth = 0, .undo = {}});
+  std::vector<int32_t> layer = {0};
+
+  // The top of the tree is searched breadth-first, so states that were seen
+  // before were seen at a depth that is at most as large.
+  std::set<std::string> seen = {initial_level.Key()};
+  Worker &worker = *workers[0];
+  const size_t min_subtrees = threads > 1 ? threads * INITIAL_SUBTREES_PER_THREAD : 1;
+  while (!layer.empty() && layer.size() < min_subtrees) {
+    std::vector<int32_t> next_layer;
+    for (int32_t id : layer) {
+      if (std::optional<SolveStatus> status = worker.monitor.Check(bound, layer.size(), nodes.size())) {
+        Abort(*status);
+        return;
+      }
+      ++worker.expanded;
+      const int depth = nodes[id].depth + 1;
+      for (auto &[next_level, undo] : nodes[id].level.SuccessorsExcept(nodes[id].undo)) {
+        if (!seen.insert(next_level.Key()).second) continue;
+        const int f = depth + Heuristic(next_level);
+        if (f > bound) {
+          worker.next_bound = std::min(worker.next_bound, f);
+          continue;
+        }
+        nodes.push_back({.level = std::move(next_level), .parent = id, .depth = depth, .undo = undo});
+        next_layer.push_back(nodes.size() - 1);
+        if (nodes.back().level.Solved()) {
+          Found(nodes.size() - 1, {});
+          return;
+        }
+      }
+    }
+    layer = std::move(next_layer);
+  }
+
+  // Deal the subtrees out in order, so that each thread starts on the part
+  // of the tree that the sequential search would explore first.
+  for (size_t i = 0; i < layer.size(); ++i) workers[i % threads]->tasks.push_back(layer[i]);
+  pending = layer.size();
+  queued = layer.size();
+}
+
+void IdaStar::Work(int t) {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stop && pending > 0) {
+    std::optional<int32_t> task = TakeTask(t);
+    if (!task) {
+      ++idle;
+      work_cv.wait(lock);
+      --idle;
+      continue;
+    }
+    std::vector<PathEntry> path = {{.level = nodes[*task].level, .undo = nodes[*task].undo}};
+    const int depth = nodes[*task].depth;
+    lock.unlock();
+    Search(t, *task, depth, path);
+    lock.lock();
+    if (--pending == 0) work_cv.notify_all();
+  }
+}
+
+std::optional<int32_t> IdaStar::TakeTask(int t) {
+  std::deque<int32_t> &own = workers[t]->tasks;
+  if (!own.empty()) {
+    int32_t id = own.back();
+    own.pop_back();
+    --queued;
+    return id;
+  }
+  for (int i = 1; i < threads; ++i) {
+    std::deque<int32_t> &other = workers[(t + i) % threads]->tasks;
+    if (!other.empty()) {
+      int32_t id = other.front();
+      other.pop_front();
+      --queued;
+      return id;
+    }
+  }
+  return {};
+}
+
+void IdaStar::Search(int t, int32_t root, int root_depth, std::vector<PathEntry> &path) {
+  Worker &worker = *workers[t];
+  if (std::optional<SolveStatus> status = worker.monitor.Check(bound, path.size(), worker.expanded)) {
+    Abort(*status);
+    return;
+  }
+  const Level &level = path.back().level;
+  const int depth = root_depth + path.size() - 1;
+  const int f = depth + Heuristic(level);
+  if (f > bound) {
+    worker.next_bound = std::min(worker.next_bound, f);
+    return;
+  }
+  if (level.Solved()) {
+    Found(root, path);
+    return;
+  }
+  if (table->Visit(level.Key(), depth)) return;
+  ++worker.expanded;
+  Successors successors = level.SuccessorsExcept(path.back().undo);
+  for (size_t k = 0; k < successors.size() && !stop.load(std::memory_order_relaxed); ++k) {
+    if (k + 1 < successors.size() && bound - depth > MIN_SHARED_HEIGHT &&
+        idle.load(std::memory_order_relaxed) > queued.load(std::memory_order_relaxed) &&
+        Share(t, root, path, successors, k)) {
+      return;
+    }
+    path.push_back({.level = std::move(successors[k].first), .undo = successors[k].second});
+    Search(t, root, root_depth, path);
+    path.pop_back();
+  }
+}
+
+bool IdaStar::Share(int t, int32_t root, const std::vector<PathEntry> &path, Successors &successors, size_t k) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (idle <= queued) return false;
+  const int32_t parent = AddPath(root, path);
+  for (; k < successors.size(); ++k) {
+    nodes.push_back({
+        .level = std::move(successors[k].first),
+        .parent = parent,
+        .depth = nodes[parent].depth + 1,
+        .undo = successors[k].second});
+    workers[t]->tasks.push_back(nodes.size() - 1);
+    ++pending;
+    ++queued;
+  }
+  work_cv.notify_all();
+  return true;
+}
+
+int32_t IdaStar::AddPath(int32_t root, const std::vector<PathEntry> &path) {
+  int32_t id = root;
+  for (size_t i = 1; i < path.size(); ++i) {
+    nodes.push_back({.level = path[i].level, .parent = id, .depth = nodes[id].depth + 1, .undo = path[i].undo});
+    id = nodes.size() - 1;
+  }
+  return id;
+}
+
+void IdaStar::Found(int32_t root, const std::vector<PathEntry> &path) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (stop) return;
+  for (int32_t id = root; id >= 0; id = nodes[id].parent) solution.push_back(nodes[id].level);
+  std::reverse(solution.begin(), solution.end());
+  for (size_t i = 1; i < path.size(); ++i) solution.push_back(path[i].level);
+  stop = true;
+  work_cv.notify_all();
+}
+
+void IdaStar::Abort(SolveStatus status) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (stop) return;
+  abort_status = status;
+  stop = true;
+  work_cv.notify_all();
+}
+
+}  // namespace
+
+SolveResult IdaStarSearch(const Level &initial_level, const SolveOptions &options) {
+  return IdaStar(initial_level, options).Run();
+}
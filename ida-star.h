@@ -0,0 +1,34 @@
+#ifndef IDA_STAR_H_INCLUDED
+#define IDA_STAR_H_INCLUDED
+
+#include "level.h"
+#include "search.h"
+
+// Searches for a shortest solution by iterative-deepening A* (IDA*): a series
+// of depth-first searches that cut off states whose f = g + h exceeds a bound,
+// where g is the number of moves made and h is the LowerBound() heuristic (see
+// heuristic.h), raised to the bound of the pattern database if
+// SolveOptions::pattern_database is set. The bound starts at h of the initial
+// level, and after each iteration is raised to the smallest f that exceeded it.
+// Since h is consistent, the first solution found is a shortest one.
+//
+// Memory use is tiny: the current path per thread, plus a transposition table
+// of bounded size (using SolveOptions::max_memory, if set) shared by the
+// threads, which prunes part of the states reached more than once within an
+// iteration.
+//
+// With SolveOptions::threads > 1, each iteration is parallelized by tree
+// splitting. The top of the search tree is expanded breadth-first until there
+// are enough subtrees to keep all threads busy, and the subtrees are dealt out
+// to per-thread queues. Threads take work from the back of their own queue,
+// and steal from the front of the others' when it is empty. While threads are
+// idle, busy threads hand out the unexplored siblings of the states they are
+// expanding as new subtrees, so the load stays balanced even when subtrees
+// differ greatly in size. Each thread tracks the smallest f beyond the bound in
+// its own subtrees, and the next bound is their minimum.
+//
+// Different threads may find different shortest solutions, so with several
+// threads, the solution returned may differ between runs.
+SolveResult IdaStarSearch(const Level &initial_level, const SolveOptions &options);
+
+#endif  // ndef IDA_STAR_H_INCLUDED
@@ -0,0 +1,270 @@
+#include "level.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+std::optional<Move> ParseMove(std::string_view s) {
+  std::istringstream iss{std::string(s)};
+  int r = 0, c = 0;
+  char comma = 0;
+  std::string direction;
+  if (!(iss >> r >> comma >> c >> direction) || comma != ',' ||
+      r < 0 || r > 255 || c < 0 || c > 255 || !(iss >> std::ws).eof()) {
+    return {};
+  }
+  if (direction != "left" && direction != "right") return {};
+  return Move{.p = Point::Narrow(r, c), .dc = static_cast<int8_t>(direction == "left" ? -1 : +1)};
+}
+
+std::string Level::Walls() const {
+  std::string walls;
+  walls.reserve(height * width);
+  for (int r = 0; r < height; ++r) {
+    for (int c = 0; c < width; ++c) {
+      const Cell &cell = grid[Index(r, c)];
+      walls += cell.type == Cell::WALL ? '#' : cell.fixed ? '*' : '.';
+    }
+  }
+  return walls;
+}
+
+void Level::UpdateSpecialized() {
+#ifdef SPECIALIZED_LEVEL
+  specialized = height == SpecializedShape::height && width == SpecializedShape::width &&
+      Walls() == SpecializedShape::walls;
+#endif
+}
+
+std::string Level::Key() const {
+  std::string key(KeySize(), '\0');
+  int i = 0;
+  for (int r = 1; r + 1 < height; ++r) {
+    for (int c = 1; c + 1 < width; ++c, ++i) {
+      const Cell &cell = grid[Index(r, c)];
+      if (cell.type == Cell::MOVABLE) {
+        key[i / 2] |= static_cast<char>((cell.color + 1) << (i % 2 * 4));
+      }
+    }
+  }
+  return key;
+}
+
+Level Level::FromKey(std::string_view key) const {
+  assert(key.size() == KeySize());
+  Level level = *this;
+  level.groups = 0;
+  int i = 0;
+  for (int r = 1; r + 1 < height; ++r) {
+    for (int c = 1; c + 1 < width; ++c, ++i) {
+      Cell &cell = level.grid[level.Index(r, c)];
+      if (cell.type == Cell::WALL) continue;
+      int v = (static_cast<uint8_t>(key[i / 2]) >> (i % 2 * 4)) & 15;
+      if (v == 0) {
+        cell = Cell();
+      } else {
+        // Fixed blocks never move, so they are always in the same place.
+        cell = Cell{
+          .type = Cell::MOVABLE,
+          .color = static_cast<uint8_t>(v - 1),
+          .group = static_cast<uint8_t>(++level.groups),
+          .fixed = grid[Index(r, c)].fixed};
+      }
+    }
+  }
+  level.UpdateConnections();
+  return level;
+}
+
+namespace {
+
+bool IsGridRow(std::string_view line) {
+  return !line.empty() && line.find_first_not_of(".#0123456789") == std::string_view::npos;
+}
+
+// Parses a line of the form "key: value". Keys consist of lowercase letters,
+// digits and hyphens.
+bool ParseMetadata(std::string_view line, std::string &key, std::string &value) {
+  size_t i = line.find(':');
+  if (i == 0 || i == std::string_view::npos) return false;
+  std::string_view k = line.substr(0, i);
+  if (k.find_first_not_of("abcdefghijklmnopqrstuvwxyz0123456789-") != std::string_view::npos) {
+    return false;
+  }
+  std::string_view v = line.substr(i + 1);
+  while (!v.empty() && v.front() == ' ') v.remove_prefix(1);
+  while (!v.empty() && v.back() == ' ') v.remove_suffix(1);
+  key = k;
+  value = v;
+  return true;
+}
+
+// Parses a list of positions of the form "r,c", separated by spaces.
+bool ParsePoints(std::string_view s, std::vector<Point> &points) {
+  std::istringstream iss{std::string(s)};
+  for (std::string token; iss >> token; ) {
+    int r = 0, c = 0;
+    char comma = 0;
+    std::istringstream tss(token);
+    if (!(tss >> r >> comma >> c) || comma != ',' || !tss.eof() ||
+        r < 1 || r > 254 || c < 1 || c > 254) {
+      return false;
+    }
+    points.push_back(Point::Narrow(r, c));
+  }
+  return true;
+}
+
+}  // namespace
+
+std::optional<std::vector<PackEntry>> ReadLevelPack(std::istream &is, std::string *error) {
+  std::vector<PackEntry> entries;
+  int line_no = 0;
+  std::string line;
+  auto fail = [&](int line, std::string_view message) {
+    if (error != nullptr) *error = "line " + std::to_string(line) + ": " + std::string(message);
+    return std::nullopt;
+  };
+  bool eof = false;
+  while (!eof) {
+    // Collect the next block of non-empty lines.
+    std::vector<std::string> block;
+    int block_line = line_no + 1;
+    while (!(eof = !std::getline(is, line)) && !line.empty()) block.push_back(line);
+    line_no += block.size() + !eof;
+    if (block.empty()) continue;
+
+    // Blocks without grid rows are notes, which are ignored.
+    if (std::none_of(block.begin(), block.end(), IsGridRow)) continue;
+
+    std::vector<std::string> grid;
+    std::string name;
+    std::optional<int> optimal;
+    std::vector<std::pair<std::string, std::string>> metadata;
+    std::vector<Point> fixed;
+    bool grid_done = false;
+    for (int i = 0; i < block.size(); ++i) {
+      if (IsGridRow(block[i])) {
+        if (grid_done) return fail(block_line + i, "grid rows must be consecutive");
+        if (!grid.empty() && block[i].size() != grid[0].size()) {
+          return fail(block_line + i, "grid rows must have equal length");
+        }
+        grid.push_back(block[i]);
+        continue;
+      }
+      grid_done = !grid.empty();
+      std::string key, value;
+      if (!ParseMetadata(block[i], key, value)) {
+        return fail(block_line + i, "expected a grid row or metadata");
+      }
+      if (key == "name") {
+        name = value;
+      } else if (key == "optimal") {
+        int n = -1;
+        std::istringstream iss(value);
+        if (!(iss >> n) || !iss.eof() || n < 0) return fail(block_line + i, "invalid optimal length");
+        optimal = n;
+      } else if (key == "fixed") {
+        if (!ParsePoints(value, fixed)) return fail(block_line + i, "invalid fixed block positions");
+      } else {
+        metadata.push_back({key, value});
+      }
+    }
+    Level level(grid);
+    for (Point p : fixed) {
+      if (!level.Fix(p)) return fail(block_line, "fixed position does not contain a block");
+    }
+    entries.push_back(PackEntry{
+        .level = std::move(level),
+        .line = block_line,
+        .name = std::move(name),
+        .optimal = optimal,
+        .metadata = std::move(metadata)});
+  }
+  return entries;
+}
+
+std::vector<std::string> ExpandLevelPaths(const std::vector<std::string> &paths) {
+  std::vector<std::string> result;
+  for (const std::string &path : paths) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(path, ec)) {
+      result.push_back(path);
+      continue;
+    }
+    std::vector<std::string> files;
+    for (const auto &entry : std::filesystem::directory_iterator(path, ec)) {
+      if (!entry.is_regular_file() || entry.path().extension() != ".txt") continue;
+      std::ifstream ifs(entry.path());
+      std::optional<std::vector<PackEntry>> entries = ReadLevelPack(ifs);
+      if (!entries || !entries->empty()) files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    result.insert(result.end(), files.begin(), files.end());
+  }
+  return result;
+}
+
+std::optional<Level> ReadLevel(std::istream &is) {
+  std::optional<std::vector<PackEntry>> entries = ReadLevelPack(is);
+  if (!entries || entries->empty()) return {};
+  return std::move((*entries)[0].level);
+}
+
+namespace {
+
+void WriteIndexArray(std::ostream &os, const char *name, const std::vector<int> &indices) {
+  os << "  static constexpr std::array<int, " << indices.size() << "> " << name << " = {";
+  for (size_t i = 0; i < indices.size(); ++i) {
+    os << (i % 12 == 0 ? "\n      " : " ") << indices[i] << ',';
+  }
+  os << "\n  };\n";
+}
+
+}  // namespace
+
+void WriteSpecializedShape(const Level &level, std::ostream &os) {
+  const int height = level.Height();
+  const int width = level.Width();
+  const std::string walls = level.Walls();
+  std::vector<int> cells;
+  std::vector<int> loose_cells;
+  for (int i = width; i < (height - 1) * width; ++i) {
+    if (walls[i] == '#') continue;
+    cells.push_back(i);
+    if (walls[i] == '.' && walls[i + width] != '#') loose_cells.push_back(i);
+  }
+
+  os << "// Generated by `solve --specialize` for a level of " << height - 2 << "x" << width - 2
+      << ". Do not edit.\n"
+      << "\n"
+      << "struct SpecializedShape : FixedShape<" << height << ", " << width << "> {\n"
+      << "  // Static layout of the level (see Level::Walls()).\n"
+      << "  static constexpr std::string_view walls =";
+  for (int r = 0; r < height; ++r) {
+    os << "\n      \"" << walls.substr(r * width, width) << '"';
+  }
+  os << ";\n"
+      << "\n"
+      << "  // Indices of the cells that are not walls.\n";
+  WriteIndexArray(os, "cells", cells);
+  os << "\n"
+      << "  // Indices of the cells that are neither walls nor fixed blocks, and are\n"
+      << "  // not directly above a wall.\n";
+  WriteIndexArray(os, "loose_cells", loose_cells);
+  os << "\n"
+      << "  static constexpr const auto &Cells() {\n"
+      << "    return cells;\n"
+      << "  }\n"
+      << "\n"
+      << "  static constexpr const auto &LooseCells() {\n"
+      << "    return loose_cells;\n"
+      << "  }\n"
+      << "};\n";
+}
@@ -0,0 +1,708 @@
+#ifndef LEVEL_H_INCLUDED
+#define LEVEL_H_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Orthogonal directions: left, right, down, up
+const int ND = 4;
+const int DR[ND] = {  0,  0, +1, -1 };
+const int DC[ND] = { -1, +1,  0,  0 };
+
+struct Point {
+  uint8_t r, c;
+
+  static Point Narrow(int r, int c) {
+    return Point{
+      .r = static_cast<uint8_t>(r),
+      .c = static_cast<uint8_t>(c)};
+  }
+
+  auto operator<=>(const Point&) const = default;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const Point &p) {
+  return os << int{p.r} << ',' << int{p.c};
+}
+
+// A move of a group one step to the left or right. The group is identified by
+// the position of one of its cells (the first in row-major order, when
+// returned by Level::Moves()). Since the grid is padded with walls, the
+// coordinates are 1-based with respect to the level description.
+struct Move {
+  Point p;
+
+  // -1 to move left, +1 to move right.
+  int8_t dc;
+
+  auto operator<=>(const Move&) const = default;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const Move &move) {
+  return os << move.p << (move.dc < 0 ? " left" : " right");
+}
+
+// Parses a move in the format written by operator<< above. Returns an empty
+// optional if the string is malformed.
+std::optional<Move> ParseMove(std::string_view s);
+
+struct Cell {
+  enum Type : uint8_t {
+    OPEN = 0,
+    WALL = 1,
+    MOVABLE = 2,
+  };
+
+  Type type = OPEN;
+
+  // Only set if type == movable.
+  // 0 for black (which doesn't connect to anything)
+  // 1+ for a color
+  uint8_t color = 0;
+
+  // 0 if type != movable.
+  // 1+ if type == movable; cells in the same group belong together.
+  uint8_t group = 0;
+
+  // Only set if type == movable.
+  // True if the block is attached to a wall, which means neither it nor
+  // the blocks in the same group can move.
+  bool fixed = false;
+
+  char Char() const {
+    return type == OPEN ? ' ' : type == WALL ? '#' : static_cast<char>('0' + color);
+  }
+
+  auto operator<=>(const Cell&) const = default;
+};
+
+// Level compares cells as bytes (see Level::operator<=>), which orders them
+// like Cell::operator<=> above, since each field is a single byte.
+static_assert(sizeof(Cell) == 4);
+
+// Time spent in the phases of Level::MoveGroup() that follow the move itself,
+// accumulated when collecting search statistics.
+struct MoveTimes {
+  std::chrono::steady_clock::duration gravity{};
+  std::chrono::steady_clock::duration connections{};
+};
+
+// Dimensions of a level (including the padding walls) that are known at
+// compile time. The hot loops of Level are instantiated for the dimensions of
+// common level sizes (see Level::WithShape()), so that their bounds, the
+// offsets between neighboring cells and the sizes of their buffers are
+// constants.
+//
+// Cells are addressed by their index in row-major order. The neighbor offsets
+// are in the order of DR and DC.
+template<int H, int W>
+struct FixedShape {
+  static constexpr int height = H;
+  static constexpr int width = W;
+  static constexpr int size = H * W;
+  static constexpr int neighbors[ND] = {-1, +1, +W, -W};
+
+  // An array with an element per cell, allocated on the stack.
+  template<class T>
+  using Array = std::array<T, size>;
+
+  // Returns an Array of value-initialized elements.
+  template<class T>
+  static Array<T> MakeArray() {
+    return {};
+  }
+
+  // Indices of the cells that the hot loops visit: all cells except the top
+  // and bottom rows of padding. Shapes that know where the walls are (see
+  // SpecializedShape below) skip more.
+  static constexpr auto Cells() {
+    return std::views::iota(width, size - width);
+  }
+
+  // Indices of the cells from which a block may fall. Blocks that are fixed or
+  // rest on a wall are still checked by DropDown().
+  static constexpr auto LooseCells() {
+    return Cells();
+  }
+};
+
+// The same as FixedShape, for dimensions that are only known at runtime.
+struct RuntimeShape {
+  RuntimeShape(int height, int width) :
+      height(height), width(width), size(height * width), neighbors{-1, +1, +width, -width} {}
+
+  int height;
+  int width;
+  int size;
+  int neighbors[ND];
+
+  template<class T>
+  using Array = std::vector<T>;
+
+  template<class T>
+  Array<T> MakeArray() const {
+    return Array<T>(size);
+  }
+
+  auto Cells() const {
+    return std::views::iota(width, size - width);
+  }
+
+  auto LooseCells() const {
+    return Cells();
+  }
+};
+
+// A solver built for a single level (see `make solve-<level>.opt`) includes
+// the header generated by WriteSpecializedShape(), which defines a
+// SpecializedShape with the static layout of that level.
+#ifdef SPECIALIZED_LEVEL
+#include SPECIALIZED_LEVEL
+#endif
+
+class LevelBenchmark;
+
+// Maybe TODO: normalize groups to deduplicate states?
+class Level {
+private:
+  // Width of the level, including padding walls on the left and right.
+  int width;
+
+  // Height of the level, including padding walls on the left and right.
+  int height;
+
+  // Number of movable groups in the level. Groups are numbered from 1 to
+  // `groups`, inclusive.
+  int groups;
+
+  // Whether the static layout of the level (see Walls()) is that of the
+  // SpecializedShape the solver was built for, if any.
+  bool specialized = false;
+
+  // Cells of the grid in row-major order (`height` rows of `width` cells;
+  // see Index()).
+  std::vector<Cell> grid;
+
+  // Defined in bench.cc, to time the private primitives below.
+  friend class LevelBenchmark;
+
+public:
+  Level(Level&&) = default;
+  Level(const Level&) = default;
+
+  Level& operator=(Level&&) = default;
+  Level& operator=(const Level&) = default;
+
+  Level(const std::vector<std::string> &input) :
+      width(input[0].size() + 2),
+      height(input.size() + 2),
+      groups(0),
+      grid(height * width) {
+    for (int r = 0; r < height; ++r) {
+      for (int c = 0; c < width; ++c) {
+        if (r == 0 || r == height - 1 || c == 0 || c == width - 1) {
+          grid[Index(r, c)] = Cell{.type = Cell::WALL};
+        } else {
+          char ch = input[r - 1][c - 1];
+          if (ch == '#') {
+            grid[Index(r, c)] = Cell{.type = Cell::WALL};
+          } else if (ch >= '1' && ch <= '9') {
+            grid[Index(r, c)] = Cell{
+              .type = Cell::MOVABLE,
+              .color = static_cast<uint8_t>(ch - '0'),
+              .group = static_cast<uint8_t>(++groups)};
+          }
+        }
+      }
+    }
+    UpdateConnections();
+    UpdateSpecialized();
+  }
+
+  int Width() const {
+    return width;
+  }
+
+  int Height() const {
+    return height;
+  }
+
+  int Groups() const {
+    return groups;
+  }
+
+  // Returns the cell at the given position (0-based, including the padding).
+  const Cell &At(int r, int c) const {
+    return grid[Index(r, c)];
+  }
+
+  // Returns the approximate number of bytes of memory used by this object,
+  // including the grid.
+  size_t MemoryUsage() const {
+    return sizeof(*this) + grid.capacity() * sizeof(grid[0]);
+  }
+
+  // Marks the block at the given position as fixed (see Cell::fixed). Returns
+  // false if the position does not contain a movable block.
+  bool Fix(Point p) {
+    if (p.r >= height || p.c >= width || grid[Index(p.r, p.c)].type != Cell::MOVABLE) return false;
+    grid[Index(p.r, p.c)].fixed = true;
+    UpdateSpecialized();
+    return true;
+  }
+
+  // Returns the static layout of the level (including the padding) as a
+  // string of `height` times `width` characters in row-major order: '#' for a
+  // wall, '*' for a fixed block, and '.' for any other cell.
+  std::string Walls() const;
+
+  // Returns the size in bytes of the keys returned by Key().
+  int KeySize() const {
+    return ((height - 2) * (width - 2) + 1) / 2;
+  }
+
+  // Returns a packed encoding of the movable cells of the level, using one
+  // nibble per interior cell. Walls are not encoded, since they never change.
+  //
+  // Groups are always the connected components of equally-colored cells, so
+  // the key does not depend on how groups happen to be numbered: two levels
+  // with the same walls and the same key represent the same game state, even
+  // if they compare unequal.
+  std::string Key() const;
+
+  // Returns the level described by `key`, which must have been returned by
+  // Key() on a level with the same walls as this one.
+  Level FromKey(std::string_view key) const;
+
+  void Print(std::ostream &os) const {
+    os << "+-";
+    for (int c = 1; c < width; ++c) os << "--";
+    os << "+" << std::endl;
+    for (int r = 0; r < height; ++r) {
+      os << '|';
+      for (int c = 0; c < width; ++c) {
+        const Cell &cell = grid[Index(r, c)];
+        os << cell.Char();
+        if (c + 1 < width) {
+          os << (cell.type == grid[Index(r, c + 1)].type && cell.group == grid[Index(r, c + 1)].group ? ' ' : '|');
+        }
+      }
+      os << "|\n";
+      if (r + 1 < height) {
+        os << '|';
+        for (int c = 0; c < width; ++c) {
+          const Cell &cell = grid[Index(r, c)];
+          os << (cell.type == grid[Index(r + 1, c)].type && cell.group == grid[Index(r + 1, c)].group ? ' ' : '-');
+          if (c + 1 < width) {
+            os << (cell.type == grid[Index(r + 1, c)].type && cell.group == grid[Index(r + 1, c)].group &&
+              cell.type == grid[Index(r, c + 1)].type && cell.group == grid[Index(r, c + 1)].group &&
+              cell.type == grid[Index(r + 1, c + 1)].type && cell.group == grid[Index(r + 1, c + 1)].group ? "·" : "+");
+          }
+        }
+        os << "|\n";
+      }
+    }
+    os << "+-";
+    for (int c = 1; c < width; ++c) os << "--";
+    os << "+" << std::endl;
+  }
+
+  // Levels are ordered by their dimensions, their number of groups, and then
+  // their cells in row-major order.
+  std::strong_ordering operator<=>(const Level &other) const {
+    auto cmp = std::tie(width, height, groups) <=> std::tie(other.width, other.height, other.groups);
+    if (cmp != 0) return cmp;
+    return CompareCells(other) <=> 0;
+  }
+
+  bool operator==(const Level &other) const {
+    return width == other.width && height == other.height && groups == other.groups &&
+        CompareCells(other) == 0;
+  }
+
+  // If `times` is not null, the time spent on gravity and on updating
+  // connections is added to it.
+  //
+  // If `undo` is not null, it is set to the move that exactly restores the
+  // original level, if the move was horizontal and displaced nothing but the
+  // group itself: no blocks were pushed along, nothing fell and no groups
+  // merged. Otherwise, it is set to an empty optional.
+  bool MoveGroup(
+      uint8_t group, int dr, int dc, MoveTimes *times = nullptr, std::optional<Move> *undo = nullptr) {
+    assert((dr == 0 && (dc == -1 || dc == +1)) || (dc == 0 && (dr == -1 || dr == +1)));
+    assert(group > 0 && group <= groups);
+    return WithShape([&](const auto &shape) {
+      return MoveGroupIn(shape, group, dr, dc, times, undo);
+    });
+  }
+
+  std::vector<Level> Successors(MoveTimes *times = nullptr) const {
+    Level copy = *this;
+    std::vector<Level> result;
+    for (int g = 1; g <= groups; ++g) {
+      for (int dc : {-1, +1}) {
+        if (copy.MoveGroup(g, 0, dc, times)) {
+          result.push_back(std::move(copy));
+          copy = *this;
+        }
+      }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+  }
+
+  // Like Successors(), but does not execute `skip` (if set), and returns with
+  // each successor the move that undoes the move leading to it, if any (see
+  // MoveGroup()).
+  //
+  // Searches pass the undo move of a level as `skip` when expanding it: that
+  // move only leads back to the level it was reached from, which they have
+  // already visited, so this saves executing it and looking up the result.
+  std::vector<std::pair<Level, std::optional<Move>>> SuccessorsExcept(
+      const std::optional<Move> &skip, MoveTimes *times = nullptr) const {
+    const int skip_group = skip ? grid[Index(skip->p.r, skip->p.c)].group : 0;
+    Level copy = *this;
+    std::vector<std::pair<Level, std::optional<Move>>> result;
+    for (int g = 1; g <= groups; ++g) {
+      for (int dc : {-1, +1}) {
+        if (g == skip_group && dc == skip->dc) continue;
+        std::optional<Move> undo;
+        if (copy.MoveGroup(g, 0, dc, times, &undo)) {
+          result.emplace_back(std::move(copy), undo);
+          copy = *this;
+        }
+      }
+    }
+
+    // Sorted like Successors(), so that searches explore states in the same
+    // order either way. Of duplicates, the first undo move is kept; any of
+    // them leads back to this level.
+    std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    result.erase(
+        std::unique(result.begin(), result.end(), [](const auto &a, const auto &b) { return a.first == b.first; }),
+        result.end());
+    return result;
+  }
+
+  // Returns all valid moves, with the levels that result from them, ordered by
+  // the position of the moved group and then by direction. Unlike
+  // Successors(), different moves that lead to the same level are all
+  // included.
+  std::vector<std::pair<Move, Level>> Moves() const {
+    std::vector<std::pair<Move, Level>> result;
+    std::vector<char> seen(groups + 1, char{false});
+    for (int r = 1; r + 1 < height; ++r) {
+      for (int c = 1; c + 1 < width; ++c) {
+        int g = grid[Index(r, c)].group;
+        if (g == 0 || seen[g]) continue;
+        seen[g] = true;
+        for (int dc : {-1, +1}) {
+          Level copy = *this;
+          if (copy.MoveGroup(g, 0, dc)) {
+            result.push_back({
+                Move{.p = Point::Narrow(r, c), .dc = static_cast<int8_t>(dc)},
+                std::move(copy)});
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  // Executes the given move, if it is valid. Returns false (and leaves the
+  // level unchanged) if the cell does not contain a movable block, or if the
+  // group cannot move in the given direction.
+  bool Apply(const Move &move) {
+    if (move.p.r >= height || move.p.c >= width || (move.dc != -1 && move.dc != +1)) return false;
+    const Cell &cell = grid[Index(move.p.r, move.p.c)];
+    return cell.type == Cell::MOVABLE && MoveGroup(cell.group, 0, move.dc);
+  }
+
+  bool Solved() const {
+    return WithShape([&](const auto &shape) { return SolvedIn(shape); });
+  }
+
+private:
+  int Index(int r, int c) const {
+    return r * width + c;
+  }
+
+  // Sets `specialized`. Called whenever the static layout changes.
+  void UpdateSpecialized();
+
+  // Calls fn(shape) with the shape of this level: the SpecializedShape if the
+  // solver was built for this level, a FixedShape if its dimensions are those
+  // of a common level size (8x12, 10x12, 10x14 or 16x16, plus padding), or a
+  // RuntimeShape otherwise.
+  template<class Fn>
+  std::invoke_result_t<Fn, RuntimeShape> WithShape(Fn &&fn) const {
+#ifdef SPECIALIZED_LEVEL
+    if (specialized) return fn(SpecializedShape());
+#endif
+    if (height == 10 && width == 14) return fn(FixedShape<10, 14>());
+    if (height == 12 && width == 14) return fn(FixedShape<12, 14>());
+    if (height == 12 && width == 16) return fn(FixedShape<12, 16>());
+    if (height == 18 && width == 18) return fn(FixedShape<18, 18>());
+    return fn(RuntimeShape(height, width));
+  }
+
+  // Compares the cells of two levels with the same dimensions as bytes.
+  int CompareCells(const Level &other) const {
+    return WithShape([&](const auto &shape) {
+      return std::memcmp(grid.data(), other.grid.data(), shape.size * sizeof(Cell));
+    });
+  }
+
+  // Scratch space for TryMoveIn(): the index and contents of each block
+  // that is moved.
+  template<class Shape>
+  using MovePoints = typename Shape::template Array<std::pair<int, Cell>>;
+
+  template<class Shape>
+  bool MoveGroupIn(
+      const Shape &shape, uint8_t group, int dr, int dc, MoveTimes *times, std::optional<Move> *undo) {
+    for (int i : shape.Cells()) {
+      if (grid[i].group != group) continue;
+      MovePoints<Shape> points = shape.template MakeArray<std::pair<int, Cell>>();
+      bool pushed = false;
+      if (!TryMoveIn(shape, points, i, dr * shape.width + dc, &pushed)) return false;
+      const int old_groups = groups;
+      bool fell;
+      if (times == nullptr) {
+        fell = DropDownIn(shape, points);
+        UpdateConnectionsIn(shape);
+      } else {
+        auto start = std::chrono::steady_clock::now();
+        fell = DropDownIn(shape, points);
+        auto dropped = std::chrono::steady_clock::now();
+        UpdateConnectionsIn(shape);
+        times->gravity += dropped - start;
+        times->connections += std::chrono::steady_clock::now() - dropped;
+      }
+      if (undo != nullptr) {
+        if (dr == 0 && !pushed && !fell && groups == old_groups) {
+          *undo = Move{.p = Point::Narrow(i / shape.width, i % shape.width + dc), .dc = static_cast<int8_t>(-dc)};
+        } else {
+          undo->reset();
+        }
+      }
+      return true;
+    }
+    assert(false);   // group not found
+    return false;
+  }
+
+  template<class Shape>
+  bool SolvedIn(const Shape &shape) const {
+    // Maybe TODO: we can calculate this on the fly by keep tracking of groups being merged.
+
+    // Note: it's not sufficient to check that each color exists only in one group
+    // since two blocks can be connected through a black block, which means they are
+    // part of the same group but the colors don't touch.
+    auto visited = shape.template MakeArray<char>();
+    auto todo = shape.template MakeArray<int>();
+    uint32_t colors = 0;
+    for (int i : shape.Cells()) {
+      const Cell &cell = grid[i];
+      if (visited[i] || cell.type != Cell::MOVABLE || cell.color == 0) continue;
+      if (colors & (uint32_t{1} << cell.color)) {
+        // second group of one color discovered
+        return false;
+      }
+      colors |= uint32_t{1} << cell.color;
+      int count = 0;
+      todo[count++] = i;
+      visited[i] = true;
+      while (count > 0) {
+        const int j = todo[--count];
+        for (int d = 0; d < ND; ++d) {
+          const int k = j + shape.neighbors[d];
+          if (!visited[k] && grid[k].type == Cell::MOVABLE && grid[k].color == cell.color) {
+            visited[k] = true;
+            todo[count++] = k;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  void UpdateConnections() {
+    WithShape([&](const auto &shape) { UpdateConnectionsIn(shape); });
+  }
+
+  template<class Shape>
+  void UpdateConnectionsIn(const Shape &shape) {
+    for (int i : shape.Cells()) {
+      const Cell &cell = grid[i];
+      if (cell.type == Cell::MOVABLE && cell.color > 0) {
+        // Right and down.
+        for (int j : {i + 1, i + shape.width}) {
+          const Cell &other = grid[j];
+          if (other.type == Cell::MOVABLE && other.group != cell.group && other.color == cell.color) {
+            int g = other.group;
+            Regroup(shape, j, g, cell.group);
+            RemoveUnusedGroupNumber(shape, g);
+          }
+        }
+      }
+    }
+  }
+
+  template<class Shape>
+  void Regroup(const Shape &shape, int i, int from, int to) {
+    if (grid[i].group != from) return;
+    grid[i].group = to;
+    for (int d = 0; d < ND; ++d) Regroup(shape, i + shape.neighbors[d], from, to);
+  }
+
+  template<class Shape>
+  void RemoveUnusedGroupNumber(const Shape &shape, int g) {
+    assert(g > 0 && g <= groups);
+    for (int i : shape.Cells()) {
+      assert(grid[i].group != g);
+      if (grid[i].group > g) --grid[i].group;
+    }
+    --groups;
+  }
+
+  bool TryMove(int r, int c, int dr, int dc) {
+    return WithShape([&](const auto &shape) {
+      auto points = shape.template MakeArray<std::pair<int, Cell>>();
+      return TryMoveIn(shape, points, Index(r, c), dr * shape.width + dc);
+    });
+  }
+
+  // Moves the block at index `start` by `offset` (one of the neighbor offsets
+  // of the shape), together with the rest of its group and the blocks in the
+  // way, unless any of them is fixed or would hit a wall. If `pushed` is not
+  // null, it is set to whether blocks of other groups were pushed along.
+  template<class Shape>
+  bool TryMoveIn(
+      const Shape &shape, MovePoints<Shape> &points, int start, int offset, bool *pushed = nullptr) {
+    // Blocks are taken off the grid as they are found, which marks them as
+    // visited, and put back if the move turns out to be blocked.
+    int count = 0;
+    bool blocked = false;
+    points[count++] = {start, grid[start]};
+    grid[start] = Cell();
+    for (int n = 0; n < count && !blocked; ++n) {
+      const auto [i, cell] = points[n];
+      if (cell.fixed) {
+        blocked = true;
+        break;
+      }
+      for (int d = 0; d < ND; ++d) {
+        const int j = i + shape.neighbors[d];
+        Cell &next = grid[j];
+        if (shape.neighbors[d] == offset) {
+          if (next.type == Cell::WALL) {
+            blocked = true;
+            break;
+          }
+          if (next.type != Cell::MOVABLE) continue;
+        } else if (next.type != Cell::MOVABLE || next.group != cell.group) {
+          continue;
+        }
+        points[count++] = {j, next};
+        next = Cell();
+      }
+    }
+    if (blocked) {
+      for (int n = 0; n < count; ++n) grid[points[n].first] = points[n].second;
+      return false;
+    }
+    for (int n = 0; n < count; ++n) {
+      const auto &[i, cell] = points[n];
+      assert(grid[i + offset].type == Cell::OPEN);
+      grid[i + offset] = cell;
+    }
+    if (pushed != nullptr) {
+      *pushed = std::any_of(points.begin(), points.begin() + count,
+          [&](const auto &p) { return p.second.group != points[0].second.group; });
+    }
+    return true;
+  }
+
+  bool DropDown() {
+    return WithShape([&](const auto &shape) {
+      auto points = shape.template MakeArray<std::pair<int, Cell>>();
+      return DropDownIn(shape, points);
+    });
+  }
+
+  // Returns whether any block fell.
+  template<class Shape>
+  bool DropDownIn(const Shape &shape, MovePoints<Shape> &points) {
+    bool fell = false;
+    for (int i : shape.LooseCells()) {
+      const Cell &cell = grid[i];
+      // Blocks that are fixed or rest on a wall cannot fall, and neither can
+      // the rest of their group.
+      if (cell.type == Cell::MOVABLE && !cell.fixed && grid[i + shape.width].type != Cell::WALL &&
+          TryMoveIn(shape, points, i, shape.width)) {
+        fell = true;
+      }
+    }
+    return fell;
+  }
+};
+
+// A level read from a level pack, together with its metadata.
+struct PackEntry {
+  Level level;
+
+  // Line number at which the level description starts (1-based).
+  int line = 0;
+
+  // Value of the `name` key, if any.
+  std::string name;
+
+  // Value of the `optimal` key: the expected length of an optimal solution.
+  std::optional<int> optimal;
+
+  // Other metadata, in order of appearance. The `fixed` key is not included
+  // here, since it is applied to the level directly.
+  std::vector<std::pair<std::string, std::string>> metadata;
+};
+
+// Reads all levels from a level pack (see levels/README.txt for the format).
+// A file containing a single level description is a valid level pack.
+// Returns an empty optional (and sets `error`, if not null) if the input is
+// malformed.
+std::optional<std::vector<PackEntry>> ReadLevelPack(std::istream &is, std::string *error = nullptr);
+
+// Replaces directories in the given list of paths by the level files (ending
+// in .txt) that they contain, in sorted order. Files in a directory that do
+// not contain any levels (like a README) are skipped, but malformed files are
+// kept, so that the caller reports them.
+std::vector<std::string> ExpandLevelPaths(const std::vector<std::string> &paths);
+
+// Reads the first level of a level pack. Returns an empty optional if the
+// input is malformed or does not contain any levels.
+std::optional<Level> ReadLevel(std::istream &is);
+
+// Writes a header that defines a SpecializedShape for the static layout of
+// the level: its walls and fixed blocks, and the cells that the hot loops of
+// Level need to visit, as constants. A solver compiled with
+// -DSPECIALIZED_LEVEL='"<header>"' uses it for every state of the level (and
+// the generic shapes for any other level).
+void WriteSpecializedShape(const Level &level, std::ostream &os);
+
+#endif  // ndef LEVEL_H_INCLUDED
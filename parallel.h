@@ -0,0 +1,34 @@
+#ifndef PARALLEL_H_INCLUDED
+#define PARALLEL_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Returns the default number of worker threads: the number of hardware threads
+// if known, or 1 otherwise.
+inline int DefaultThreadCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls fn(i) for each i in the range [0, n), using up to `threads` threads.
+// Indices are handed out dynamically, so the calls may happen in any order.
+template<class Fn>
+void ParallelFor(size_t n, int threads, const Fn &fn) {
+  if (threads <= 1 || n <= 1) {
+    for (size_t i = 0; i < n; ++i) fn(i);
+    return;
+  }
+  std::atomic<size_t> next = 0;
+  auto work = [&]() {
+    for (size_t i; (i = next++) < n; ) fn(i);
+  };
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < std::min<size_t>(threads, n); ++t) workers.emplace_back(work);
+  work();
+  for (std::thread &worker : workers) worker.join();
+}
+
+#endif  // ndef PARALLEL_H_INCLUDED
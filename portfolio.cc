@@ -0,0 +1,107 @@
+#include "portfolio.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "level.h"
+#include "search.h"
+
+namespace {
+
+struct Entrant {
+  SearchAlgorithm algorithm;
+
+  // Fraction of the memory limit available to this search. Greedy and beam
+  // search either finish quickly or not at all, so they get less.
+  double memory_share;
+};
+
+// Breadth-first search must come first (see SolvePortfolio()).
+constexpr Entrant ENTRANTS[] = {
+  {.algorithm = SearchAlgorithm::BFS, .memory_share = 0.375},
+  {.algorithm = SearchAlgorithm::ASTAR, .memory_share = 0.375},
+  {.algorithm = SearchAlgorithm::GREEDY, .memory_share = 0.125},
+  {.algorithm = SearchAlgorithm::BEAM, .memory_share = 0.125},
+};
+
+constexpr size_t ENTRANT_COUNT = std::size(ENTRANTS);
+
+// Interval at which the cancellation flag of the caller is checked while
+// waiting for the searches.
+constexpr std::chrono::milliseconds POLL_INTERVAL(10);
+
+// Returns whether the result of the given algorithm settles the level.
+bool IsFinal(SearchAlgorithm algorithm, const SolveResult &result) {
+  return result.status == SolveStatus::UNSOLVABLE ||
+      (result.status == SolveStatus::SOLVED && FindsShortestSolutions(algorithm));
+}
+
+}  // namespace
+
+SolveResult SolvePortfolio(const Level &initial_level, const SolveOptions &options) {
+  std::atomic<bool> stop = false;
+  std::mutex mutex;
+  std::condition_variable finished_cv;
+  std::vector<std::optional<SolveResult>> results(ENTRANT_COUNT);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < ENTRANT_COUNT; ++i) {
+    SolveOptions entrant_options = options;
+    entrant_options.algorithm = ENTRANTS[i].algorithm;
+    entrant_options.max_memory = options.max_memory * ENTRANTS[i].memory_share;
+    entrant_options.cancelled = &stop;
+    entrant_options.anytime = false;
+    // Only the solution that is returned needs to be shortened.
+    entrant_options.shortcut_depth = 0;
+    if (ENTRANTS[i].algorithm != SearchAlgorithm::BFS) {
+      entrant_options.collect_stats = false;
+      entrant_options.progress = nullptr;
+    }
+    threads.emplace_back([&, i, entrant_options]() {
+      SolveResult result = Solve(initial_level, entrant_options);
+      std::lock_guard<std::mutex> lock(mutex);
+      results[i] = std::move(result);
+      finished_cv.notify_one();
+    });
+  }
+
+  // Wait until some search settles the level, or all searches have ended.
+  std::optional<size_t> winner;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      bool all_ended = true;
+      for (size_t i = 0; i < ENTRANT_COUNT && !winner; ++i) {
+        if (!results[i]) {
+          all_ended = false;
+        } else if (IsFinal(ENTRANTS[i].algorithm, *results[i])) {
+          winner = i;
+        }
+      }
+      if (winner || all_ended || (options.cancelled != nullptr && *options.cancelled)) break;
+      finished_cv.wait_for(lock, POLL_INTERVAL);
+    }
+  }
+  stop = true;
+  for (std::thread &thread : threads) thread.join();
+  if (winner) return std::move(*results[*winner]);
+
+  SolveResult result = std::move(*results[0]);
+  for (size_t i = 1; i < ENTRANT_COUNT; ++i) {
+    const SolveResult &other = *results[i];
+    result.lower_bound = std::max(result.lower_bound, other.lower_bound);
+    if (other.status == SolveStatus::SOLVED &&
+        (result.steps.empty() || other.steps.size() < result.steps.size())) {
+      result.steps = other.steps;
+    }
+  }
+  return result;
+}
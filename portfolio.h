@@ -0,0 +1,22 @@
+#ifndef PORTFOLIO_H_INCLUDED
+#define PORTFOLIO_H_INCLUDED
+
+#include "level.h"
+#include "search.h"
+
+// Solves a level by running several algorithms concurrently, each on its own
+// thread: breadth-first search and A*, which find shortest solutions, and
+// greedy and beam search, which usually find some solution much sooner. The
+// memory limit is divided between them.
+//
+// As soon as one of the searches finds a shortest solution or proves that
+// there is none, the others are cancelled, and its result is returned. If the
+// searches for a shortest solution are aborted instead (e.g. because the time
+// limit is exceeded), the result of breadth-first search is returned, with the
+// shortest solution found by any search (see SolveResult::steps) and the
+// best lower bound.
+//
+// Only breadth-first search reports progress and collects statistics.
+SolveResult SolvePortfolio(const Level &initial_level, const SolveOptions &options);
+
+#endif  // ndef PORTFOLIO_H_INCLUDED
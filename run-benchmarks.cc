@@ -0,0 +1,355 @@
+// End-to-end benchmark for the solver.
+//
+// Runs a solver binary on each level file a number of times, and records the
+// wall time, the number of states expanded, the peak resident set size and the
+// resulting number of states expanded per second. The results are written as
+// JSON, and may be compared against an earlier result (the baseline), in which
+// case the exit status indicates whether any level regressed by more than the
+// given threshold.
+//
+// Each run is a separate process, so that the peak RSS is measured per run.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "level.h"
+
+extern char **environ;
+
+namespace {
+
+struct RunResult {
+  double seconds = 0;
+  int64_t expanded = 0;
+  int64_t peak_rss_kb = 0;
+};
+
+struct LevelResult {
+  std::string level;
+  int runs = 0;
+
+  // Median and minimum wall time over all runs.
+  double seconds = 0;
+  double min_seconds = 0;
+
+  int64_t expanded = 0;
+  int64_t peak_rss_kb = 0;
+  double states_per_second = 0;
+};
+
+// Returns the total of the "expanded N states" counts in the solver's log.
+int64_t ParseExpanded(std::string_view log) {
+  static constexpr std::string_view prefix = "expanded ";
+  int64_t total = 0;
+  for (size_t pos = log.find(prefix); pos != std::string_view::npos; pos = log.find(prefix, pos)) {
+    pos += prefix.size();
+    int64_t n = 0;
+    while (pos < log.size() && log[pos] >= '0' && log[pos] <= '9') n = 10*n + (log[pos++] - '0');
+    total += n;
+  }
+  return total;
+}
+
+// Runs `solver` on `level` (with standard output discarded) and measures it.
+std::optional<RunResult> Run(const std::string &solver, const std::vector<std::string> &solver_args,
+    const std::string &level) {
+  int pipe_fds[2];
+  if (pipe(pipe_fds) != 0) {
+    std::cerr << "Failed to create pipe!" << std::endl;
+    return {};
+  }
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDERR_FILENO);
+  posix_spawn_file_actions_addclose(&actions, pipe_fds[0]);
+  posix_spawn_file_actions_addclose(&actions, pipe_fds[1]);
+
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(solver.c_str()));
+  for (const std::string &arg : solver_args) argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(const_cast<char*>(level.c_str()));
+  argv.push_back(nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid;
+  int error = posix_spawn(&pid, solver.c_str(), &actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(pipe_fds[1]);
+  if (error != 0) {
+    close(pipe_fds[0]);
+    std::cerr << "Failed to run solver (" << solver << ": " << strerror(error) << ")!" << std::endl;
+    return {};
+  }
+
+  std::string log;
+  char buffer[4096];
+  for (ssize_t n; (n = read(pipe_fds[0], buffer, sizeof(buffer))) > 0; ) log.append(buffer, n);
+  close(pipe_fds[0]);
+
+  int status;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) != pid) {
+    std::cerr << "Failed to wait for solver!" << std::endl;
+    return {};
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::cerr << "Solver failed on " << level << ":\n" << log << std::flush;
+    return {};
+  }
+  return RunResult{
+    .seconds = elapsed.count(),
+    .expanded = ParseExpanded(log),
+    .peak_rss_kb = usage.ru_maxrss,
+  };
+}
+
+std::optional<LevelResult> Benchmark(const std::string &solver, const std::vector<std::string> &solver_args,
+    const std::string &level, int runs) {
+  std::vector<double> seconds;
+  LevelResult result = {.level = level, .runs = runs};
+  for (int i = 0; i < runs; ++i) {
+    std::optional<RunResult> run = Run(solver, solver_args, level);
+    if (!run) return {};
+    if (i > 0 && run->expanded != result.expanded) {
+      std::cerr << "Warning: " << level << " expanded " << run->expanded
+          << " states, but " << result.expanded << " before.\n";
+    }
+    seconds.push_back(run->seconds);
+    result.expanded = run->expanded;
+    result.peak_rss_kb = std::max(result.peak_rss_kb, run->peak_rss_kb);
+  }
+  std::sort(seconds.begin(), seconds.end());
+  result.seconds = seconds[seconds.size() / 2];
+  result.min_seconds = seconds.front();
+  result.states_per_second = result.seconds > 0 ? result.expanded / result.seconds : 0;
+  return result;
+}
+
+std::string JsonString(std::string_view s) {
+  std::string result = "\"";
+  for (char ch : s) {
+    if (ch == '"' || ch == '\\') result += '\\';
+    result += ch;
+  }
+  result += '"';
+  return result;
+}
+
+void WriteJson(std::ostream &os, const std::string &solver, int runs, const std::vector<LevelResult> &results) {
+  os << "{\n"
+      << "  \"solver\": " << JsonString(solver) << ",\n"
+      << "  \"runs\": " << runs << ",\n"
+      << "  \"levels\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const LevelResult &r = results[i];
+    os << "    {\"level\": " << JsonString(r.level)
+        << ", \"seconds\": " << std::fixed << std::setprecision(6) << r.seconds
+        << ", \"min_seconds\": " << r.min_seconds
+        << ", \"expanded\": " << r.expanded
+        << ", \"peak_rss_kb\": " << r.peak_rss_kb
+        << ", \"states_per_second\": " << std::setprecision(0) << r.states_per_second
+        << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  os << "  ]\n}\n";
+}
+
+// Returns the value of the numeric field `key` in the JSON object `object`.
+std::optional<double> NumberField(std::string_view object, std::string_view key) {
+  std::string needle = JsonString(key) + ":";
+  size_t pos = object.find(needle);
+  if (pos == std::string_view::npos) return {};
+  std::string value(object.substr(pos + needle.size()));
+  char *end;
+  double d = std::strtod(value.c_str(), &end);
+  if (end == value.c_str()) return {};
+  return d;
+}
+
+// Reads the per-level results from a file written by WriteJson(). This does
+// not parse arbitrary JSON, only the format written above: one level object
+// per line.
+std::optional<std::map<std::string, LevelResult>> ReadBaseline(const std::string &filename) {
+  std::ifstream ifs(filename);
+  if (!ifs) {
+    std::cerr << "Failed to open baseline file (" << filename << ")!" << std::endl;
+    return {};
+  }
+  static constexpr std::string_view prefix = "{\"level\": \"";
+  std::map<std::string, LevelResult> result;
+  std::string line;
+  while (std::getline(ifs, line)) {
+    size_t begin = line.find(prefix);
+    if (begin == std::string::npos) continue;
+    begin += prefix.size();
+    size_t end = line.find('"', begin);
+    if (end == std::string::npos) continue;
+    LevelResult r = {.level = line.substr(begin, end - begin)};
+    std::string_view object = std::string_view(line).substr(end);
+    std::optional<double> seconds = NumberField(object, "seconds");
+    std::optional<double> expanded = NumberField(object, "expanded");
+    std::optional<double> peak_rss_kb = NumberField(object, "peak_rss_kb");
+    if (!seconds || !expanded || !peak_rss_kb) {
+      std::cerr << "Failed to parse baseline file (" << filename << ", level " << r.level << ")!" << std::endl;
+      return {};
+    }
+    r.seconds = *seconds;
+    r.expanded = *expanded;
+    r.peak_rss_kb = *peak_rss_kb;
+    result[r.level] = r;
+  }
+  return result;
+}
+
+// Differences in wall time below this (in seconds) are considered noise, even
+// when they exceed the relative threshold. This matters for the small levels,
+// which are solved in a few milliseconds.
+constexpr double MIN_TIME_DIFFERENCE = 0.02;
+
+// Compares `current` against `baseline`, prints a report, and returns the
+// number of regressions: levels that became slower or used more memory by
+// more than `threshold` (a fraction), or that expanded more states.
+int Compare(std::ostream &os, const std::map<std::string, LevelResult> &baseline,
+    const std::vector<LevelResult> &current, double threshold) {
+  int regressions = 0;
+  os << std::left << std::setw(32) << "level" << std::right
+      << std::setw(12) << "seconds" << std::setw(9) << "change"
+      << std::setw(12) << "expanded" << std::setw(9) << "change"
+      << std::setw(12) << "rss (KiB)" << std::setw(9) << "change" << '\n';
+  auto change = [](double before, double after) {
+    std::ostringstream oss;
+    oss << std::showpos << std::fixed << std::setprecision(1) << (before > 0 ? 100*(after/before - 1) : 0.0) << '%';
+    return oss.str();
+  };
+  for (const LevelResult &r : current) {
+    auto it = baseline.find(r.level);
+    if (it == baseline.end()) {
+      os << std::left << std::setw(32) << r.level << std::right << "  (not in baseline)\n";
+      continue;
+    }
+    const LevelResult &b = it->second;
+    bool slower = r.seconds > b.seconds * (1 + threshold) && r.seconds > b.seconds + MIN_TIME_DIFFERENCE;
+    bool bigger = r.peak_rss_kb > b.peak_rss_kb * (1 + threshold);
+    bool more_states = r.expanded > b.expanded;
+    os << std::left << std::setw(32) << r.level << std::right << std::fixed
+        << std::setw(12) << std::setprecision(3) << r.seconds << std::setw(9) << change(b.seconds, r.seconds)
+        << std::setw(12) << r.expanded << std::setw(9) << change(b.expanded, r.expanded)
+        << std::setw(12) << r.peak_rss_kb << std::setw(9) << change(b.peak_rss_kb, r.peak_rss_kb);
+    if (slower || bigger || more_states) {
+      os << "  REGRESSION";
+      ++regressions;
+    }
+    os << '\n';
+  }
+  os << std::flush;
+  return regressions;
+}
+
+void PrintUsage() {
+  std::cout << "Usage: run-benchmarks [options] <solver> <level.txt|directory>... [-- <solver options>]\n"
+      "\n"
+      "Options:\n"
+      "  --runs=N          run the solver N times per level (default: 3)\n"
+      "  --output=FILE     write results as JSON to FILE (default: standard output)\n"
+      "  --baseline=FILE   compare against earlier results; the exit status is 1\n"
+      "                    if any level regressed\n"
+      "  --threshold=PCT   allowed increase in time and memory before a level counts\n"
+      "                    as a regression, in percent (default: 10)\n"
+      << std::flush;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int runs = 3;
+  const char *output = nullptr;
+  const char *baseline_filename = nullptr;
+  double threshold = 10;
+  std::vector<std::string> positional;
+  std::vector<std::string> solver_args;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--") {
+      solver_args.assign(argv + i + 1, argv + argc);
+      break;
+    } else if (arg.starts_with("--runs=")) {
+      runs = atoi(argv[i] + arg.find('=') + 1);
+      if (runs < 1) {
+        std::cerr << "Invalid number of runs!" << std::endl;
+        return 1;
+      }
+    } else if (arg.starts_with("--output=")) {
+      output = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--baseline=")) {
+      baseline_filename = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--threshold=")) {
+      threshold = atof(argv[i] + arg.find('=') + 1);
+    } else if (arg.starts_with("--")) {
+      PrintUsage();
+      return 1;
+    } else {
+      positional.push_back(argv[i]);
+    }
+  }
+  if (positional.size() < 2) {
+    PrintUsage();
+    return 1;
+  }
+  std::string solver = positional[0];
+  std::vector<std::string> levels = ExpandLevelPaths({positional.begin() + 1, positional.end()});
+
+  std::optional<std::map<std::string, LevelResult>> baseline;
+  if (baseline_filename != nullptr) {
+    baseline = ReadBaseline(baseline_filename);
+    if (!baseline) return 1;
+  }
+
+  std::vector<LevelResult> results;
+  for (const std::string &level : levels) {
+    std::optional<LevelResult> result = Benchmark(solver, solver_args, level, runs);
+    if (!result) return 1;
+    std::cerr << level << ": " << std::fixed << std::setprecision(3) << result->seconds << " s, "
+        << result->expanded << " states, " << result->peak_rss_kb << " KiB" << std::endl;
+    results.push_back(*result);
+  }
+
+  if (output == nullptr) {
+    WriteJson(std::cout, solver, runs, results);
+  } else {
+    std::ofstream ofs(output);
+    WriteJson(ofs, solver, runs, results);
+    if (!ofs) {
+      std::cerr << "Failed to write output file (" << output << ")!" << std::endl;
+      return 1;
+    }
+  }
+
+  if (baseline) {
+    // The report goes to standard error if standard output has the JSON.
+    std::ostream &os = output == nullptr ? std::cerr : std::cout;
+    int regressions = Compare(os, *baseline, results, threshold / 100);
+    if (regressions > 0) {
+      os << regressions << " regression(s) over the " << std::defaultfloat << threshold << "% threshold." << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
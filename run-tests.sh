@@ -22,3 +22,26 @@ do
         "./${bin}" "${level}" | diff - "${solution}"
     done
 done
+
+# A search that is stopped early must continue from its checkpoint, and find
+# the same solution.
+checkpoint_dir="$(mktemp -d)"
+trap 'rm -rf "${checkpoint_dir}"' EXIT
+for bin in "$@"; do
+    echo "Verifying checkpoint and resume of levels/level-06.txt with ${bin}..."
+    rm -rf "${checkpoint_dir}"/*
+    if "./${bin}" --checkpoint="${checkpoint_dir}" --time-limit=0.05 levels/level-06.txt >/dev/null; then
+        echo "Search was expected to stop at the time limit!"
+        exit 1
+    fi
+    "./${bin}" --resume="${checkpoint_dir}" levels/level-06.txt | diff - solutions/level-06.txt
+done
+
+# Search algorithms other than breadth-first search must find solutions of the
+# lengths given in the pack; the solver fails otherwise.
+for bin in "$@"; do
+    for options in "--algorithm=astar" "--algorithm=idastar --threads=2" "--portfolio"; do
+        echo "Verifying tests/optimal.txt with ${bin} ${options}..."
+        "./${bin}" ${options} tests/optimal.txt >/dev/null
+    done
+done
@@ -0,0 +1,70 @@
+#ifndef SEARCH_MONITOR_H_INCLUDED
+#define SEARCH_MONITOR_H_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "search.h"
+
+// Enforces the time limit and the cancellation flag of a search, and reports
+// its progress (see SolveOptions). This is shared by all search algorithms.
+class SearchMonitor {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Number of states expanded between checks of the time limit and the
+  // cancellation flag.
+  static constexpr int CHECK_INTERVAL = 256;
+
+  explicit SearchMonitor(const SolveOptions &options) :
+      options(options),
+      start_time(Clock::now()),
+      deadline(start_time + ToDuration(options.time_limit)),
+      next_progress(start_time + ToDuration(options.progress_interval)),
+      progress_requests(options.progress_requests != nullptr ? options.progress_requests->load() : 0) {}
+
+  Clock::time_point StartTime() const {
+    return start_time;
+  }
+
+  // Should be called before each expansion. Returns the status with which the
+  // search must stop, if any. The limits are only checked once every
+  // CHECK_INTERVAL calls, to keep the overhead low.
+  std::optional<SolveStatus> Check(int depth, int64_t frontier, int64_t visited) {
+    if (calls++ % CHECK_INTERVAL != 0) return {};
+    if (options.cancelled != nullptr && *options.cancelled) return SolveStatus::CANCELLED;
+    if (options.time_limit == 0 && !options.progress) return {};
+    auto now = Clock::now();
+    if (options.time_limit > 0 && now > deadline) return SolveStatus::TIME_LIMIT_EXCEEDED;
+    if (options.progress) {
+      int requests = options.progress_requests != nullptr ? options.progress_requests->load() : 0;
+      if (requests != progress_requests || (options.progress_interval > 0 && now >= next_progress)) {
+        progress_requests = requests;
+        while (options.progress_interval > 0 && next_progress <= now) {
+          next_progress += ToDuration(options.progress_interval);
+        }
+        options.progress({
+            .depth = depth,
+            .frontier = frontier,
+            .visited = visited,
+            .seconds = std::chrono::duration<double>(now - start_time).count()});
+      }
+    }
+    return {};
+  }
+
+private:
+  static Clock::duration ToDuration(double seconds) {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  }
+
+  const SolveOptions &options;
+  const Clock::time_point start_time;
+  const Clock::time_point deadline;
+  Clock::time_point next_progress;
+  int progress_requests;
+  int64_t calls = 0;
+};
+
+#endif  // ndef SEARCH_MONITOR_H_INCLUDED
@@ -0,0 +1,103 @@
+#include "search-stats.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void PrintPhase(std::ostream &os, const char *name, double seconds, double total) {
+  os << "  " << std::left << std::setw(18) << name << std::right
+      << std::setw(10) << std::setprecision(3) << seconds << " s"
+      << std::setw(8) << std::setprecision(1) << (total > 0 ? 100 * seconds / total : 0) << "%\n";
+}
+
+void PrintMemory(std::ostream &os, const char *name, size_t bytes) {
+  os << "  " << std::left << std::setw(18) << name << std::right
+      << std::setw(10) << std::setprecision(1) << bytes / 1048576.0 << " MiB\n";
+}
+
+}  // namespace
+
+void AddSearchStats(SearchStats &stats, const SearchStats &other) {
+  stats.generated += other.generated;
+  stats.inserted += other.inserted;
+  stats.goal_checks += other.goal_checks;
+  if (stats.layers.size() < other.layers.size()) stats.layers.resize(other.layers.size());
+  for (size_t i = 0; i < other.layers.size(); ++i) {
+    stats.layers[i].states += other.layers[i].states;
+    stats.layers[i].seconds += other.layers[i].seconds;
+  }
+  stats.total_seconds += other.total_seconds;
+  stats.move_generation_seconds += other.move_generation_seconds;
+  stats.gravity_seconds += other.gravity_seconds;
+  stats.connections_seconds += other.connections_seconds;
+  stats.goal_test_seconds += other.goal_test_seconds;
+  stats.visited_set_seconds += other.visited_set_seconds;
+  stats.visited_set_bytes = std::max(stats.visited_set_bytes, other.visited_set_bytes);
+  stats.queue_bytes = std::max(stats.queue_bytes, other.queue_bytes);
+  stats.parents_bytes = std::max(stats.parents_bytes, other.parents_bytes);
+}
+
+void PrintSearchStats(std::ostream &os, const SearchStats &stats) {
+  const double other_seconds = stats.total_seconds - stats.move_generation_seconds -
+      stats.gravity_seconds - stats.connections_seconds - stats.goal_test_seconds -
+      stats.visited_set_seconds;
+  os << std::fixed
+      << "States generated: " << stats.generated << '\n'
+      << "States inserted: " << stats.inserted << '\n'
+      << "Duplicate ratio: " << std::setprecision(3) << stats.DuplicateRatio() << '\n'
+      << "Goal checks: " << stats.goal_checks << '\n'
+      << "States per second: " << std::setprecision(0)
+      << (stats.total_seconds > 0 ? stats.inserted / stats.total_seconds : 0) << '\n'
+      << "\nTime:\n";
+  PrintPhase(os, "move generation", stats.move_generation_seconds, stats.total_seconds);
+  PrintPhase(os, "gravity", stats.gravity_seconds, stats.total_seconds);
+  PrintPhase(os, "connections", stats.connections_seconds, stats.total_seconds);
+  PrintPhase(os, "goal test", stats.goal_test_seconds, stats.total_seconds);
+  PrintPhase(os, "visited set", stats.visited_set_seconds, stats.total_seconds);
+  PrintPhase(os, "other", other_seconds, stats.total_seconds);
+  PrintPhase(os, "total", stats.total_seconds, stats.total_seconds);
+  os << "\nPeak memory:\n";
+  PrintMemory(os, "visited set", stats.visited_set_bytes);
+  PrintMemory(os, "queue", stats.queue_bytes);
+  PrintMemory(os, "parent links", stats.parents_bytes);
+  os << '\n'
+      << std::setw(5) << "Depth" << ' '
+      << std::setw(12) << "States" << ' '
+      << std::setw(12) << "Seconds" << '\n';
+  for (int depth = 0; depth < stats.layers.size(); ++depth) {
+    const SearchStats::Layer &layer = stats.layers[depth];
+    os << std::setw(5) << depth << ' '
+        << std::setw(12) << layer.states << ' '
+        << std::setw(12) << std::setprecision(3) << layer.seconds << '\n';
+  }
+  os << std::defaultfloat << std::flush;
+}
+
+void PrintSearchStatsJson(std::ostream &os, const SearchStats &stats) {
+  os << std::fixed << std::setprecision(6)
+      << "{\"generated\": " << stats.generated
+      << ", \"inserted\": " << stats.inserted
+      << ", \"duplicate_ratio\": " << stats.DuplicateRatio()
+      << ", \"goal_checks\": " << stats.goal_checks
+      << ", \"seconds\": {\"total\": " << stats.total_seconds
+      << ", \"move_generation\": " << stats.move_generation_seconds
+      << ", \"gravity\": " << stats.gravity_seconds
+      << ", \"connections\": " << stats.connections_seconds
+      << ", \"goal_test\": " << stats.goal_test_seconds
+      << ", \"visited_set\": " << stats.visited_set_seconds
+      << "}, \"peak_bytes\": {\"visited_set\": " << stats.visited_set_bytes
+      << ", \"queue\": " << stats.queue_bytes
+      << ", \"parents\": " << stats.parents_bytes
+      << "}, \"layers\": [";
+  for (size_t i = 0; i < stats.layers.size(); ++i) {
+    if (i > 0) os << ", ";
+    os << "{\"states\": " << stats.layers[i].states << ", \"seconds\": " << stats.layers[i].seconds << "}";
+  }
+  os << "]}" << std::defaultfloat << std::endl;
+}
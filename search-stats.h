@@ -0,0 +1,72 @@
+#ifndef SEARCH_STATS_H_INCLUDED
+#define SEARCH_STATS_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Statistics collected by Solve() when SolveOptions::collect_stats is set.
+struct SearchStats {
+  // Number of successor states generated (after removing duplicates among
+  // the successors of a single state).
+  int64_t generated = 0;
+
+  // Number of states that were new, and were added to the visited set
+  // (including the initial state).
+  int64_t inserted = 0;
+
+  // Number of calls to Level::Solved().
+  int64_t goal_checks = 0;
+
+  struct Layer {
+    // Number of states at this depth.
+    int64_t states = 0;
+
+    // Time spent expanding the states at this depth, in seconds.
+    double seconds = 0;
+  };
+
+  // Layers of the search, indexed by depth. If the search ended early, the
+  // last layer was only partially expanded.
+  std::vector<Layer> layers;
+
+  // Total time of the search, and the time spent in each phase, in seconds.
+  // Move generation includes copying and sorting successor states, but not
+  // applying gravity or updating connections, which are listed separately.
+  double total_seconds = 0;
+  double move_generation_seconds = 0;
+  double gravity_seconds = 0;
+  double connections_seconds = 0;
+  double goal_test_seconds = 0;
+  double visited_set_seconds = 0;
+
+  // Peak memory used by each data structure, in bytes (approximately).
+  size_t visited_set_bytes = 0;
+  size_t queue_bytes = 0;
+  size_t parents_bytes = 0;
+
+  // Fraction of generated states that had been visited before.
+  double DuplicateRatio() const {
+    return generated > 0 ? double(generated - (inserted - 1)) / generated : 0;
+  }
+};
+
+// Adds the statistics of another search to `stats`, when a search consists of
+// several separate searches. Layers are added by depth, and peak memory is the
+// maximum of both, since the searches run one after another.
+void AddSearchStats(SearchStats &stats, const SearchStats &other);
+
+enum class StatsFormat {
+  NONE,
+  TEXT,
+  JSON,
+};
+
+// Prints the statistics as a human-readable report.
+void PrintSearchStats(std::ostream &os, const SearchStats &stats);
+
+// Prints the statistics as a JSON object, on a single line.
+void PrintSearchStatsJson(std::ostream &os, const SearchStats &stats);
+
+#endif  // ndef SEARCH_STATS_H_INCLUDED
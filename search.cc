@@ -0,0 +1,559 @@
+#include "search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "beam-search.h"
+#include "best-first.h"
+#include "checkpoint.h"
+#include "compact-search.h"
+#include "decompose.h"
+#include "heuristic.h"
+#include "ida-star.h"
+#include "level.h"
+#include "portfolio.h"
+#include "search-monitor.h"
+#include "search-stats.h"
+#include "shorten.h"
+#include "state-set.h"
+#include "transposition-table.h"
+
+namespace {
+
+using Clock = SearchMonitor::Clock;
+
+double ToSeconds(Clock::duration d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+// Continues a breadth-first search in `search`. Returns the solution, if
+// found, in `result`. If the memory used exceeds `max_memory` (if nonzero),
+// this stops with status MEMORY_LIMIT_EXCEEDED, after which the caller may
+// fall back to iterative deepening. If `layer_done` is set, it is called each
+// time a layer has been expanded completely.
+void ContinueCompactSearch(
+    const Level &initial_level, size_t max_memory, CompactSearch &search,
+    SearchMonitor &monitor, SearchStats *stats, SolveResult &result,
+    const std::function<void(const CompactSearch&)> &layer_done = {}) {
+  auto layer_start_time = Clock::now();
+  while (search.next < search.states.Size()) {
+    if (search.next == search.layer_end) {
+      if (stats != nullptr) {
+        auto now = Clock::now();
+        stats->layers.back().seconds += ToSeconds(now - layer_start_time);
+        stats->layers.push_back({.states = static_cast<int64_t>(search.states.Size()) - search.layer_end, .seconds = 0});
+        layer_start_time = now;
+      }
+      ++search.depth;
+      search.layer_end = search.states.Size();
+      if (layer_done) layer_done(search);
+    }
+    std::optional<SolveStatus> status = monitor.Check(
+        search.depth, search.states.Size() - search.next, search.states.Size());
+    if (!status && max_memory > 0 && search.MemoryUsage() > max_memory) {
+      status = SolveStatus::MEMORY_LIMIT_EXCEEDED;
+    }
+    if (status) {
+      result.status = *status;
+      break;
+    }
+    const uint32_t id = search.next++;
+    for (Level &next_level : initial_level.FromKey(search.states.Key(id)).Successors()) {
+      if (stats != nullptr) ++stats->goal_checks;
+      if (next_level.Solved()) {
+        result.status = SolveStatus::SOLVED;
+        result.steps.push_back(std::move(next_level));
+        for (int32_t j = id; j >= 0; j = search.parents[j]) {
+          result.steps.push_back(initial_level.FromKey(search.states.Key(j)));
+        }
+        std::reverse(result.steps.begin(), result.steps.end());
+        break;
+      }
+      if (stats != nullptr) ++stats->generated;
+      if (search.states.Insert(next_level.Key()).second) {
+        if (stats != nullptr) ++stats->inserted;
+        search.parents.push_back(id);
+      }
+    }
+    if (result.status == SolveStatus::SOLVED) break;
+  }
+  if (stats != nullptr) {
+    stats->layers.back().seconds += ToSeconds(Clock::now() - layer_start_time);
+    stats->visited_set_bytes = std::max(stats->visited_set_bytes, search.states.MemoryUsage());
+    stats->parents_bytes = std::max(stats->parents_bytes, search.parents.capacity() * sizeof(search.parents[0]));
+  }
+  result.expanded = search.states.Size();
+  if (result.status != SolveStatus::SOLVED) result.lower_bound = search.depth + 1;
+}
+
+// Depth-first search for a solution of exactly `bound` moves, where `path`
+// holds the levels from the initial level (at depth 0) to the level being
+// expanded, and `undo` is the move back to the previous level, if any. On
+// success, the rest of the solution is appended to `path`.
+//
+// `cut_off` counts the levels that were left unexpanded at depth `bound`,
+// except those that were reached at a smaller depth later on (as far as the
+// transposition table remembers).
+bool DepthLimitedSearch(
+    std::vector<Level> &path, const std::optional<Move> &undo, int bound, TranspositionTable &table,
+    SearchMonitor &monitor, int64_t &expanded, int64_t &cut_off, SolveResult &result) {
+  std::optional<SolveStatus> status = monitor.Check(bound, path.size(), expanded);
+  if (status) {
+    result.status = *status;
+    return false;
+  }
+  ++expanded;
+  const int depth = path.size();
+  for (auto &[next_level, next_undo] : path.back().SuccessorsExcept(undo)) {
+    if (depth == bound) {
+      if (next_level.Solved()) {
+        path.push_back(std::move(next_level));
+        return true;
+      }
+      if (!table.Visit(next_level.Key(), depth)) ++cut_off;
+      continue;
+    }
+    int previous_depth;
+    if (table.Visit(next_level.Key(), depth, &previous_depth)) continue;
+    if (previous_depth == bound) --cut_off;
+    path.push_back(std::move(next_level));
+    if (DepthLimitedSearch(path, next_undo, bound, table, monitor, expanded, cut_off, result)) return true;
+    if (result.status != SolveStatus::UNSOLVABLE) return false;
+    path.pop_back();
+  }
+  return false;
+}
+
+// Iterative deepening: searches for solutions of `min_length` moves, then one
+// more, and so on, using memory proportional to the solution length (plus a
+// transposition table that fits in `table_memory` bytes). The first solution
+// found is therefore a shortest one, if `min_length` is a lower bound.
+//
+// If an iteration leaves no level at the bound that was not also reached at a
+// smaller depth, no level is exactly `bound` moves away, so every reachable
+// level has been checked, and the level is unsolvable. This requires the
+// transposition table to remember the levels at the bound, so on levels with
+// more states than fit in the table, the search may still only stop when it
+// is cancelled or runs out of time.
+void IterativeDeepening(
+    const Level &initial_level, int min_length, size_t table_memory,
+    SearchMonitor &monitor, SolveResult &result) {
+  TranspositionTable table(initial_level.KeySize(),
+      table_memory / TranspositionTable::SlotSize(initial_level.KeySize()));
+  int64_t expanded = 0;
+  for (int bound = std::max(min_length, 1); ; ++bound) {
+    result.lower_bound = bound;
+    table.NextIteration();
+    table.Visit(initial_level.Key(), 0);
+    std::vector<Level> path = {initial_level};
+    int64_t cut_off = 0;
+    if (DepthLimitedSearch(path, std::nullopt, bound, table, monitor, expanded, cut_off, result)) {
+      result.status = SolveStatus::SOLVED;
+      result.steps = std::move(path);
+      break;
+    }
+    if (result.status != SolveStatus::UNSOLVABLE || cut_off == 0) break;
+  }
+  result.expanded += expanded;
+}
+
+// Called when a compact search ran out of memory: all states up to the
+// current depth have been checked, so a solution needs at least depth + 1
+// moves. Frees the visited set, and continues with iterative deepening,
+// using the memory budget for a transposition table instead.
+void FallBackToIterativeDeepening(
+    const Level &initial_level, size_t max_memory, CompactSearch &search,
+    SearchMonitor &monitor, SolveResult &result) {
+  const int min_length = search.depth + 1;
+  search.states = StateSet(initial_level.KeySize());
+  search.parents = {};
+  result.status = SolveStatus::UNSOLVABLE;
+  result.strategy = SearchStrategy::ITERATIVE_DEEPENING;
+  IterativeDeepening(initial_level, min_length, max_memory, monitor, result);
+}
+
+// Searches with packed states from the start (or from `options.resume`), and
+// writes a checkpoint to `options.checkpoint_dir` after each layer.
+SolveResult SolveWithCheckpoints(const Level &initial_level, const SolveOptions &options, SearchMonitor &monitor) {
+  SolveResult result;
+  result.strategy = SearchStrategy::COMPACT_BFS;
+  CompactSearch search(initial_level.KeySize());
+  if (options.resume != nullptr) {
+    search = std::move(*options.resume);
+  } else {
+    search.states.Insert(initial_level.Key());
+    search.parents.push_back(-1);
+    search.layer_end = 1;
+    search.stats.goal_checks = 1;
+    search.stats.inserted = 1;
+    search.stats.layers.push_back({.states = 1, .seconds = 0});
+  }
+  const double previous_seconds = search.stats.total_seconds;
+  auto elapsed = [&]() { return previous_seconds + ToSeconds(Clock::now() - monitor.StartTime()); };
+
+  std::optional<CheckpointWriter> writer;
+  if (!options.checkpoint_dir.empty()) {
+    writer = CheckpointWriter::Create(options.checkpoint_dir, initial_level, search, options.resume != nullptr);
+    if (writer && options.resume == nullptr && !writer->Write(search, 0)) writer.reset();
+  }
+  ContinueCompactSearch(initial_level, options.max_memory, search, monitor, &search.stats, result,
+      [&](const CompactSearch &current) {
+        // After a failure, the search continues without checkpoints.
+        if (writer && !writer->Write(current, elapsed())) writer.reset();
+      });
+  search.stats.total_seconds = elapsed();
+  if (options.collect_stats) result.stats = search.stats;
+  if (result.status == SolveStatus::MEMORY_LIMIT_EXCEEDED) {
+    FallBackToIterativeDeepening(initial_level, options.max_memory, search, monitor, result);
+    if (result.stats) result.stats->total_seconds = elapsed();
+  }
+  return result;
+}
+
+// Implements Solve(), apart from the anytime search.
+SolveResult SolveBreadthFirst(const Level &initial_level, const SolveOptions &options) {
+  SearchMonitor monitor(options);
+  const auto start_time = monitor.StartTime();
+  SolveResult result;
+  SearchStats *stats = options.collect_stats ? &result.stats.emplace() : nullptr;
+  if (stats != nullptr) {
+    stats->goal_checks = 1;
+    stats->inserted = 1;
+    stats->layers.push_back({.states = 1, .seconds = 0});
+  }
+  if (initial_level.Solved()) {
+    result.status = SolveStatus::SOLVED;
+    result.steps.push_back(initial_level);
+    if (stats != nullptr) stats->total_seconds = ToSeconds(Clock::now() - start_time);
+    return result;
+  }
+  if (!options.checkpoint_dir.empty() || options.resume != nullptr) {
+    return SolveWithCheckpoints(initial_level, options, monitor);
+  }
+
+  // Approximate memory used per state: the level itself, plus the overhead of
+  // a map node, an iterator in `levels`, an index in `previous_level_index`
+  // and an undo move.
+  const size_t level_size = initial_level.MemoryUsage() + 48;
+  const size_t state_size = level_size +
+      sizeof(std::map<Level, int>::iterator) + sizeof(int) + sizeof(std::optional<Move>);
+
+  std::map<Level, int> level_index;
+  std::vector<std::map<Level, int>::iterator> levels;
+  std::vector<int> previous_level_index;
+  levels.push_back(level_index.insert({initial_level, 0}).first);
+  previous_level_index.push_back(-1);
+
+  // The move that leads from each state back to its parent, if any (see
+  // Level::SuccessorsExcept()), which need not be explored.
+  std::vector<std::optional<Move>> undo_moves;
+  undo_moves.emplace_back();
+
+  // States with index below `layer_end` are at most at depth `depth`.
+  int depth = 0;
+  int layer_end = 1;
+
+  // Used only when collecting statistics.
+  MoveTimes move_times;
+  Clock::duration successors_time{}, goal_test_time{}, visited_set_time{};
+  auto layer_start_time = start_time;
+  // Returns f(), adding the time it took to `total` if collecting statistics.
+  auto timed = [&](Clock::duration &total, auto &&f) {
+    if (stats == nullptr) return f();
+    auto before = Clock::now();
+    auto value = f();
+    total += Clock::now() - before;
+    return value;
+  };
+  auto finish_stats = [&]() {
+    if (stats == nullptr) return;
+    auto now = Clock::now();
+    stats->layers.back().seconds = ToSeconds(now - layer_start_time);
+    stats->total_seconds = ToSeconds(now - start_time);
+    stats->gravity_seconds = ToSeconds(move_times.gravity);
+    stats->connections_seconds = ToSeconds(move_times.connections);
+    stats->move_generation_seconds = ToSeconds(successors_time - move_times.gravity - move_times.connections);
+    stats->goal_test_seconds = ToSeconds(goal_test_time);
+    stats->visited_set_seconds = ToSeconds(visited_set_time);
+    // Nothing is freed during the search, so the final sizes are the peaks.
+    stats->visited_set_bytes = level_index.size() * level_size;
+    stats->queue_bytes = levels.capacity() * sizeof(levels[0]) + undo_moves.capacity() * sizeof(undo_moves[0]);
+    stats->parents_bytes = previous_level_index.capacity() * sizeof(previous_level_index[0]);
+  };
+
+  int i = 0;
+  for (; i < level_index.size(); ++i) {
+    if (i == layer_end) {
+      if (stats != nullptr) {
+        auto now = Clock::now();
+        stats->layers.back().seconds = ToSeconds(now - layer_start_time);
+        stats->layers.push_back({.states = static_cast<int64_t>(levels.size()) - layer_end, .seconds = 0});
+        layer_start_time = now;
+      }
+      ++depth;
+      layer_end = levels.size();
+    }
+    if (std::optional<SolveStatus> status = monitor.Check(depth, levels.size() - i, levels.size())) {
+      result.status = *status;
+      break;
+    }
+    if (options.max_memory > 0 && levels.size() * state_size > options.max_memory) {
+      result.status = SolveStatus::MEMORY_LIMIT_EXCEEDED;
+      break;
+    }
+    std::vector<std::pair<Level, std::optional<Move>>> successors = timed(successors_time,
+        [&]() { return levels[i]->first.SuccessorsExcept(undo_moves[i], stats != nullptr ? &move_times : nullptr); });
+    for (size_t k = 0; k < successors.size(); ++k) {
+      Level &next_level = successors[k].first;
+      if (stats != nullptr) ++stats->goal_checks;
+      if (timed(goal_test_time, [&]() { return next_level.Solved(); })) {
+        result.status = SolveStatus::SOLVED;
+        result.steps.push_back(std::move(next_level));
+        break;
+      }
+      if (stats != nullptr) ++stats->generated;
+      int j = levels.size();
+      auto res = timed(visited_set_time, [&]() { return level_index.insert({std::move(next_level), j}); });
+      if (res.second) {
+        if (stats != nullptr) ++stats->inserted;
+        levels.push_back(res.first);
+        previous_level_index.push_back(i);
+        undo_moves.push_back(successors[k].second);
+      }
+    }
+    if (result.status != SolveStatus::SOLVED) continue;
+    finish_stats();
+    result.expanded = levels.size();
+    for (int j = i; j >= 0; j = previous_level_index[j]) {
+      result.steps.push_back(levels[j]->first);
+    }
+    std::reverse(result.steps.begin(), result.steps.end());
+    return result;
+  }
+  finish_stats();
+  result.expanded = levels.size();
+  result.lower_bound = depth + 1;
+  if (result.status != SolveStatus::MEMORY_LIMIT_EXCEEDED) return result;
+
+  // Out of memory: convert the visited states to packed keys, freeing the
+  // levels as we go, and continue the search from where it stopped. The
+  // converted states stay in breadth-first order, so the frontier and the
+  // current layer map onto ranges of ids.
+  result.status = SolveStatus::UNSOLVABLE;
+  result.strategy = SearchStrategy::COMPACT_BFS;
+  CompactSearch search(initial_level.KeySize());
+  {
+    std::vector<int32_t> id_of(levels.size());
+    for (int j = 0; j < levels.size(); ++j) {
+      if (j == i) search.next = search.states.Size();
+      if (j == layer_end) search.layer_end = search.states.Size();
+      auto [id, inserted] = search.states.Insert(levels[j]->first.Key());
+      if (inserted) search.parents.push_back(j == 0 ? -1 : id_of[previous_level_index[j]]);
+      id_of[j] = id;
+      level_index.erase(levels[j]);
+    }
+    if (layer_end == levels.size()) search.layer_end = search.states.Size();
+    search.depth = depth;
+  }
+  levels = {};
+  previous_level_index = {};
+  undo_moves = {};
+  ContinueCompactSearch(initial_level, options.max_memory, search, monitor, stats, result);
+  if (result.status == SolveStatus::MEMORY_LIMIT_EXCEEDED) {
+    FallBackToIterativeDeepening(initial_level, options.max_memory, search, monitor, result);
+  }
+  if (stats != nullptr) stats->total_seconds = ToSeconds(Clock::now() - start_time);
+  return result;
+}
+
+// Implements Solve() for breadth-first search, which may run a greedy search
+// alongside (see SolveOptions::anytime).
+SolveResult SolveAnytime(const Level &initial_level, const SolveOptions &options) {
+  SolveResult result;
+  if (!options.anytime || options.time_limit <= 0) {
+    result = SolveBreadthFirst(initial_level, options);
+  } else {
+    // Run a greedy search alongside, which usually finds some solution long
+    // before the breadth-first search would finish.
+    std::atomic<bool> finished = false;
+    SolveOptions greedy_options;
+    greedy_options.time_limit = options.time_limit;
+    greedy_options.max_memory = options.max_memory / 4;
+    greedy_options.cancelled = &finished;
+    SolveResult greedy_result;
+    std::thread greedy_thread([&]() {
+      greedy_result = BestFirstSearch(initial_level, greedy_options, {.g = 0, .h = 1});
+    });
+    SolveOptions bfs_options = options;
+    bfs_options.max_memory -= greedy_options.max_memory;
+    result = SolveBreadthFirst(initial_level, bfs_options);
+    finished = true;
+    greedy_thread.join();
+    if (result.status != SolveStatus::SOLVED && result.status != SolveStatus::UNSOLVABLE) {
+      if (greedy_result.status == SolveStatus::SOLVED) {
+        result.steps = std::move(greedy_result.steps);
+      } else if (greedy_result.status == SolveStatus::UNSOLVABLE) {
+        // The greedy search exhausted the state space.
+        result.status = SolveStatus::UNSOLVABLE;
+        result.expanded = greedy_result.expanded;
+      }
+    }
+  }
+  if (result.status != SolveStatus::SOLVED) {
+    result.lower_bound = std::max(result.lower_bound, LowerBound(initial_level));
+  }
+  return result;
+}
+
+// Solves a level that consists of several regions (see decompose.h) by
+// solving each region separately, and combining the solutions.
+SolveResult SolveRegions(
+    const Level &initial_level, const std::vector<Region> &regions, const SolveOptions &options) {
+  const Clock::time_point start_time = Clock::now();
+  SolveResult result;
+  result.status = SolveStatus::SOLVED;
+
+  // Blocks in different regions can never connect.
+  std::map<int, int> region_of_color;
+  for (int i = 0; i < regions.size(); ++i) {
+    for (const Component &component : FindComponents(regions[i].level)) {
+      auto [it, inserted] = region_of_color.emplace(component.color, i);
+      if (!inserted && it->second != i) {
+        result.status = SolveStatus::UNSOLVABLE;
+        return result;
+      }
+    }
+  }
+
+  std::vector<Move> moves;
+  bool complete = true;  // whether all regions have a solution
+  for (const Region &region : regions) {
+    SolveOptions region_options = options;
+    if (options.time_limit > 0) {
+      region_options.time_limit = options.time_limit - ToSeconds(Clock::now() - start_time);
+      if (region_options.time_limit <= 0) {
+        result.status = SolveStatus::TIME_LIMIT_EXCEEDED;
+        complete = false;
+        break;
+      }
+    }
+    SolveResult region_result = Solve(region.level, region_options);
+    result.expanded += region_result.expanded;
+    result.strategy = std::max(result.strategy, region_result.strategy);
+    if (region_result.stats) {
+      if (!result.stats) result.stats.emplace();
+      AddSearchStats(*result.stats, *region_result.stats);
+    }
+    if (region_result.status == SolveStatus::UNSOLVABLE) {
+      result.status = SolveStatus::UNSOLVABLE;
+      result.steps.clear();
+      return result;
+    }
+    if (region_result.status != SolveStatus::SOLVED && result.status == SolveStatus::SOLVED) {
+      result.status = region_result.status;
+    }
+    if (region_result.status == SolveStatus::SOLVED && FindsShortestSolutions(options.algorithm)) {
+      result.lower_bound += region_result.steps.size() - 1;
+    } else {
+      result.lower_bound += region_result.lower_bound;
+    }
+    if (region_result.steps.empty()) {
+      complete = false;
+    } else {
+      std::optional<std::vector<Move>> region_moves = ExtractMoves(region_result.steps);
+      for (Move move : *region_moves) {
+        move.p = Point::Narrow(move.p.r + region.dr, move.p.c + region.dc);
+        moves.push_back(move);
+      }
+    }
+    if (region_result.status == SolveStatus::TIME_LIMIT_EXCEEDED ||
+        region_result.status == SolveStatus::CANCELLED) {
+      complete = false;
+      break;
+    }
+  }
+  if (complete) result.steps = ReplayMoves(initial_level, moves).value();
+  if (result.status == SolveStatus::SOLVED) result.lower_bound = 0;
+  return result;
+}
+
+}  // namespace
+
+SolveResult Solve(Level initial_level, const SolveOptions &options) {
+  // Each region is solved (and its solution shortened) by a recursive call.
+  if (options.decompose && options.checkpoint_dir.empty() && options.resume == nullptr) {
+    std::vector<Region> regions = FindRegions(initial_level);
+    if (regions.size() > 1) return SolveRegions(initial_level, regions, options);
+  }
+
+  // Shortening the solution counts towards the time limit of the search.
+  SolveOptions shorten_options = options;
+  shorten_options.progress = nullptr;
+  SearchMonitor shorten_monitor(shorten_options);
+
+  SolveResult result;
+  switch (options.algorithm) {
+    case SearchAlgorithm::BFS:
+      result = SolveAnytime(initial_level, options);
+      break;
+    case SearchAlgorithm::ASTAR:
+      result = BestFirstSearch(initial_level, options, {.g = 1, .h = 1});
+      break;
+    case SearchAlgorithm::WEIGHTED_ASTAR:
+      result = BestFirstSearch(initial_level, options, {.g = 1, .h = options.weight});
+      break;
+    case SearchAlgorithm::GREEDY:
+      result = BestFirstSearch(initial_level, options, {.g = 0, .h = 1});
+      break;
+    case SearchAlgorithm::IDA_STAR:
+      result = IdaStarSearch(initial_level, options);
+      break;
+    case SearchAlgorithm::BEAM:
+      result = BeamSearch(initial_level, options, options.beam_width);
+      break;
+    case SearchAlgorithm::PORTFOLIO:
+      result = SolvePortfolio(initial_level, options);
+      break;
+  }
+  const bool shortest = result.status == SolveStatus::SOLVED && FindsShortestSolutions(options.algorithm);
+  if (!shortest && options.shortcut_depth > 0 && result.steps.size() > 2) {
+    result.steps = ShortenSolution(std::move(result.steps), options.shortcut_depth, shorten_monitor);
+  }
+  return result;
+}
+
+std::optional<std::vector<Move>> ExtractMoves(const std::vector<Level> &steps) {
+  std::vector<Move> moves;
+  for (size_t i = 0; i + 1 < steps.size(); ++i) {
+    std::string next_key = steps[i + 1].Key();
+    bool found = false;
+    for (const auto &[move, next_level] : steps[i].Moves()) {
+      if (next_level.Key() == next_key) {
+        moves.push_back(move);
+        found = true;
+        break;
+      }
+    }
+    if (!found) return {};
+  }
+  return moves;
+}
+
+std::optional<std::vector<Level>> ReplayMoves(const Level &initial, const std::vector<Move> &moves) {
+  std::vector<Level> steps;
+  steps.push_back(initial);
+  for (const Move &move : moves) {
+    Level level = steps.back();
+    if (!level.Apply(move)) return {};
+    steps.push_back(std::move(level));
+  }
+  return steps;
+}
@@ -0,0 +1,213 @@
+#ifndef SEARCH_H_INCLUDED
+#define SEARCH_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "level.h"
+#include "search-stats.h"
+
+struct CompactSearch;
+
+// A snapshot of a running search, passed to SolveOptions::progress.
+struct SearchProgress {
+  // Depth of the states currently being expanded.
+  int depth = 0;
+
+  // Number of states discovered but not yet expanded.
+  int64_t frontier = 0;
+
+  // Number of distinct states discovered so far.
+  int64_t visited = 0;
+
+  // Time since the start of the search, in seconds.
+  double seconds = 0;
+};
+
+enum class SearchAlgorithm {
+  // Breadth-first search, which falls back to other strategies when the
+  // memory limit is reached (see SearchStrategy).
+  BFS,
+
+  // Best-first searches (see best-first.h). A* finds shortest solutions like
+  // breadth-first search; weighted A* and greedy search find longer solutions
+  // (or prove that there are none), but usually much faster.
+  ASTAR,
+  WEIGHTED_ASTAR,
+  GREEDY,
+
+  // Iterative-deepening A* (see ida-star.h), which finds shortest solutions
+  // using very little memory, and can use several threads.
+  IDA_STAR,
+
+  // Beam search (see beam-search.h), which uses little memory, but may fail
+  // to find a solution even if there is one.
+  BEAM,
+
+  // Several of the above, run concurrently (see portfolio.h). This finds
+  // shortest solutions.
+  PORTFOLIO,
+};
+
+// Returns whether the given algorithm only finds shortest solutions.
+inline bool FindsShortestSolutions(SearchAlgorithm algorithm) {
+  return algorithm == SearchAlgorithm::BFS || algorithm == SearchAlgorithm::ASTAR ||
+      algorithm == SearchAlgorithm::IDA_STAR || algorithm == SearchAlgorithm::PORTFOLIO;
+}
+
+struct SolveOptions {
+  // Search algorithm. The options below that are not limits are only
+  // supported by breadth-first search.
+  SearchAlgorithm algorithm = SearchAlgorithm::BFS;
+
+  // Weight of the heuristic in weighted A* (at least 1), which bounds how
+  // many times longer than a shortest solution the solution may be.
+  double weight = 2;
+
+  // Whether to split levels into regions that are separated by walls, and
+  // solve each region separately (see decompose.h). This is not done when
+  // writing or resuming checkpoints.
+  bool decompose = true;
+
+  // Whether A*, weighted A* and IDA* use pattern databases (see heuristic.h),
+  // which take some time to build, but usually save much more.
+  bool pattern_database = true;
+
+  // Number of states kept per layer in beam search.
+  int beam_width = 10000;
+
+  // Number of threads used by IDA*, and to build pattern databases.
+  int threads = 1;
+
+  // Solutions that are not necessarily shortest are shortened afterwards by
+  // searching for shortcuts of at most this many moves (see shorten.h), unless
+  // this is 0.
+  int shortcut_depth = 6;
+
+  // Maximum time to search, in seconds, or 0 for no limit.
+  double time_limit = 0;
+
+  // Approximate limit on the memory used by the search, in bytes, or 0 for no
+  // limit. When the limit is reached, the search switches to a strategy that
+  // uses less memory (see SearchStrategy) instead of failing.
+  size_t max_memory = 0;
+
+  // If not null, the search is aborted when this becomes true.
+  const std::atomic<bool> *cancelled = nullptr;
+
+  // If true, and there is a time limit, a greedy best-first search (see
+  // best-first.h) runs alongside the search on a separate thread, so that a
+  // solution can be returned even if the time limit is exceeded. It uses a
+  // quarter of the memory limit.
+  bool anytime = false;
+
+  // Whether to collect statistics (see SolveResult::stats). This slows down
+  // the search somewhat, since each phase is timed separately.
+  bool collect_stats = false;
+
+  // If set, this is called (on the searching thread) every
+  // `progress_interval` seconds if that is positive, and whenever the value of
+  // `*progress_requests` changes (e.g. when it is incremented by a signal
+  // handler), if that is not null.
+  std::function<void(const SearchProgress&)> progress;
+  double progress_interval = 0;
+  const std::atomic<int> *progress_requests = nullptr;
+
+  // If not empty, the search stores states as packed keys from the start
+  // (see CompactSearch), and writes a checkpoint to this directory after each
+  // layer (see checkpoint.h).
+  std::string checkpoint_dir;
+
+  // If not null, the search continues from this state (read from a
+  // checkpoint), which is moved from, instead of starting from scratch. In
+  // that case, `checkpoint_dir` must either be empty, or be the directory from
+  // which the checkpoint was read.
+  CompactSearch *resume = nullptr;
+};
+
+enum class SolveStatus {
+  SOLVED,
+  UNSOLVABLE,
+  TIME_LIMIT_EXCEEDED,
+  MEMORY_LIMIT_EXCEEDED,
+  CANCELLED,
+
+  // An incomplete search (see SearchAlgorithm::BEAM) ended without finding a
+  // solution, which does not prove that there is none.
+  INCOMPLETE,
+};
+
+// Search strategies, in the order in which Solve() falls back to them when
+// the memory limit is reached.
+enum class SearchStrategy {
+  // Breadth-first search, storing each visited level in full.
+  BFS,
+
+  // Breadth-first search, storing visited levels as packed keys.
+  COMPACT_BFS,
+
+  // Iterative deepening depth-first search, with a transposition table of
+  // bounded size. This uses little memory, but may revisit many states, and
+  // only detects unsolvable levels if the table can hold their states.
+  ITERATIVE_DEEPENING,
+
+  // Best-first search (see best-first.h), which does not switch strategies.
+  BEST_FIRST,
+
+  // Beam search (see beam-search.h), which does not switch strategies either.
+  BEAM,
+
+  // Iterative-deepening A* (see ida-star.h), which does not need to switch
+  // strategies, since it uses little memory to begin with.
+  IDA_STAR,
+};
+
+struct SolveResult {
+  SolveStatus status = SolveStatus::UNSOLVABLE;
+
+  // If solved: the sequence of levels from the initial level to a solved
+  // level, where each level follows from the previous one by a single move.
+  //
+  // If the search was aborted, this may still contain a solution that is not
+  // necessarily a shortest one (see SolveOptions::anytime and
+  // SolveOptions::shortcut_depth).
+  std::vector<Level> steps;
+
+  // If the search was aborted: a proven lower bound on the number of moves
+  // in any solution, or 0 if unknown.
+  int lower_bound = 0;
+
+  // Number of distinct states discovered by the search. After falling back to
+  // iterative deepening, states expanded more than once are counted each time.
+  int64_t expanded = 0;
+
+  // Strategy used when the search finished.
+  SearchStrategy strategy = SearchStrategy::BFS;
+
+  // Search statistics, if SolveOptions::collect_stats was set.
+  std::optional<SearchStats> stats;
+};
+
+// Finds a solution for the given level using the algorithm selected in
+// `options`. By default, this finds a shortest solution using breadth-first
+// search. (If the memory limit is reached, this falls back to other strategies
+// that still find a shortest solution; see SearchStrategy.)
+//
+// This function is thread-safe: different levels may be solved concurrently.
+SolveResult Solve(Level initial_level, const SolveOptions &options = {});
+
+// Returns the moves that lead from each level in `steps` to the next, or an
+// empty optional if some level does not follow from the previous one.
+std::optional<std::vector<Move>> ExtractMoves(const std::vector<Level> &steps);
+
+// Executes the given moves, starting from `initial`, and returns the list of
+// levels visited (including the initial level). Returns an empty optional if
+// any of the moves is invalid.
+std::optional<std::vector<Level>> ReplayMoves(const Level &initial, const std::vector<Move> &moves);
+
+#endif  // ndef SEARCH_H_INCLUDED
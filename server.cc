@@ -0,0 +1,294 @@
+#include "server.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "level.h"
+#include "search.h"
+#include "solution-cache.h"
+
+namespace {
+
+// Maximum size of the level text in a request.
+const size_t MAX_REQUEST_SIZE = 1 << 20;
+
+struct Connection {
+  explicit Connection(int fd) : fd(fd) {}
+
+  ~Connection() {
+    close(fd);
+  }
+
+  // Writes a complete response. Safe to call from multiple threads.
+  void Write(std::string_view data) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    while (!data.empty()) {
+      ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+      if (n <= 0) return;  // client went away
+      data.remove_prefix(n);
+    }
+  }
+
+  const int fd;
+
+  std::mutex write_mutex;
+
+  // Cancellation flag of the most recent request on this connection.
+  std::mutex cancel_mutex;
+  std::shared_ptr<std::atomic<bool>> latest_cancelled;
+};
+
+struct Job {
+  std::shared_ptr<Connection> connection;
+  std::string id;
+  std::string text;
+  std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+// Result of a completed search, as stored in the in-memory cache.
+struct RecentResult {
+  SolveStatus status;
+  std::vector<Move> moves;
+  int64_t expanded;
+};
+
+// A least-recently-used cache of search results, keyed by canonical layout.
+class RecentResults {
+public:
+  explicit RecentResults(size_t capacity) : capacity(capacity) {}
+
+  std::optional<RecentResult> Lookup(const std::string &layout) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(layout);
+    if (it == index.end()) return {};
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+  }
+
+  void Store(const std::string &layout, RecentResult result) {
+    if (capacity == 0) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(layout);
+    if (it != index.end()) {
+      entries.erase(it->second);
+      index.erase(it);
+    }
+    entries.emplace_front(layout, std::move(result));
+    index[layout] = entries.begin();
+    if (entries.size() > capacity) {
+      index.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+
+private:
+  const size_t capacity;
+  std::mutex mutex;
+  std::list<std::pair<std::string, RecentResult>> entries;
+  std::unordered_map<std::string, std::list<std::pair<std::string, RecentResult>>::iterator> index;
+};
+
+const char *StatusName(SolveStatus status) {
+  switch (status) {
+    case SolveStatus::SOLVED: return "solved";
+    case SolveStatus::UNSOLVABLE: return "unsolvable";
+    case SolveStatus::TIME_LIMIT_EXCEEDED: return "time-limit";
+    case SolveStatus::MEMORY_LIMIT_EXCEEDED: return "memory-limit";
+    case SolveStatus::CANCELLED: return "cancelled";
+    case SolveStatus::INCOMPLETE: return "incomplete";
+  }
+  return "error";
+}
+
+class Server {
+public:
+  explicit Server(const ServeOptions &options)
+      : options(options), recent(options.recent_results) {}
+
+  int Run(const std::string &socket_path);
+
+private:
+  void HandleConnection(std::shared_ptr<Connection> connection);
+  void Enqueue(Job job);
+  void Work();
+  std::string Process(const Job &job);
+
+  const ServeOptions options;
+  RecentResults recent;
+
+  std::mutex queue_mutex;
+  std::condition_variable queue_cv;
+  std::deque<Job> queue;
+};
+
+int Server::Run(const std::string &socket_path) {
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "Socket path too long (" << socket_path << ")!" << std::endl;
+    return 1;
+  }
+  strcpy(addr.sun_path, socket_path.c_str());
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(socket_path.c_str());
+  if (listen_fd < 0 ||
+      bind(listen_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(listen_fd, SOMAXCONN) != 0) {
+    std::cerr << "Failed to listen on " << socket_path << ": " << strerror(errno) << std::endl;
+    if (listen_fd >= 0) close(listen_fd);
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  for (int i = 0; i < options.threads; ++i) std::thread(&Server::Work, this).detach();
+  std::cerr << "Listening on " << socket_path << std::endl;
+  for (;;) {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "Failed to accept connection: " << strerror(errno) << std::endl;
+      return 1;
+    }
+    std::thread(&Server::HandleConnection, this, std::make_shared<Connection>(fd)).detach();
+  }
+}
+
+// Reads requests from the connection until the client closes it.
+void Server::HandleConnection(std::shared_ptr<Connection> connection) {
+  std::string buffer;
+  char chunk[4096];
+  for (;;) {
+    // Parse as many complete requests as are available.
+    for (;;) {
+      size_t eol = buffer.find('\n');
+      if (eol == std::string::npos) break;
+      std::istringstream header(buffer.substr(0, eol));
+      std::string command, id;
+      size_t length = 0;
+      if (!(header >> command >> id >> length) || command != "solve" || length > MAX_REQUEST_SIZE) {
+        std::string response = id.empty() ? "" : "id: " + id + "\n";
+        connection->Write(response + "status: error\nerror: malformed request\n\n");
+        return;
+      }
+      if (buffer.size() < eol + 1 + length) break;
+      Job job = {
+        .connection = connection,
+        .id = id,
+        .text = buffer.substr(eol + 1, length),
+        .cancelled = std::make_shared<std::atomic<bool>>(false)};
+      buffer.erase(0, eol + 1 + length);
+      {
+        // A new request supersedes the previous one.
+        std::lock_guard<std::mutex> lock(connection->cancel_mutex);
+        if (connection->latest_cancelled) *connection->latest_cancelled = true;
+        connection->latest_cancelled = job.cancelled;
+      }
+      Enqueue(std::move(job));
+    }
+    ssize_t n = read(connection->fd, chunk, sizeof(chunk));
+    if (n <= 0) break;
+    buffer.append(chunk, n);
+  }
+  // The connection is closed when the last outstanding job releases it.
+}
+
+void Server::Enqueue(Job job) {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    queue.push_back(std::move(job));
+  }
+  queue_cv.notify_one();
+}
+
+void Server::Work() {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex);
+      queue_cv.wait(lock, [this]() { return !queue.empty(); });
+      job = std::move(queue.front());
+      queue.pop_front();
+    }
+    job.connection->Write(Process(job));
+  }
+}
+
+std::string Server::Process(const Job &job) {
+  std::ostringstream response;
+  response << "id: " << job.id << '\n';
+  if (*job.cancelled) {
+    response << "status: cancelled\n\n";
+    return response.str();
+  }
+  std::istringstream iss(job.text);
+  std::string error;
+  std::optional<std::vector<PackEntry>> entries = ReadLevelPack(iss, &error);
+  if (!entries || entries->size() != 1) {
+    if (entries) error = "expected exactly one level";
+    response << "status: error\nerror: " << error << "\n\n";
+    return response.str();
+  }
+  const Level &level = (*entries)[0].level;
+  const std::string layout = CanonicalLayout(level);
+
+  std::optional<RecentResult> result = recent.Lookup(layout);
+  if (!result) {
+    std::optional<SolveResult> solve_result;
+    if (options.cache != nullptr) solve_result = options.cache->Lookup(level);
+    bool cached = solve_result.has_value();
+    auto start_time = std::chrono::steady_clock::now();
+    if (!cached) {
+      SolveOptions solve_options = options.solve;
+      solve_options.cancelled = job.cancelled.get();
+      solve_result = Solve(level, solve_options);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    result = RecentResult{.status = solve_result->status, .moves = {}, .expanded = solve_result->expanded};
+    if (result->status == SolveStatus::SOLVED) {
+      result->moves = ExtractMoves(solve_result->steps).value();
+    }
+    if (result->status == SolveStatus::SOLVED || result->status == SolveStatus::UNSOLVABLE) {
+      recent.Store(layout, *result);
+    }
+    if (options.cache != nullptr && !cached && ShouldCache(*solve_result, options.solve.algorithm)) {
+      options.cache->Store(level, *solve_result, elapsed.count());
+    }
+  }
+  response << "status: " << StatusName(result->status) << '\n'
+      << "expanded: " << result->expanded << '\n';
+  if (result->status == SolveStatus::SOLVED) {
+    response << "moves: " << result->moves.size() << '\n';
+    for (const Move &move : result->moves) response << move << '\n';
+  }
+  response << '\n';
+  return response.str();
+}
+
+}  // namespace
+
+int Serve(const std::string &socket_path, const ServeOptions &options) {
+  // The server runs until the process is terminated, so it is never destroyed.
+  Server *server = new Server(options);
+  return server->Run(socket_path);
+}
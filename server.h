@@ -0,0 +1,66 @@
+#ifndef SERVER_H_INCLUDED
+#define SERVER_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+#include "search.h"
+#include "solution-cache.h"
+
+// Protocol
+// --------
+//
+// Clients connect to a Unix domain stream socket, and send any number of
+// requests of the form:
+//
+//    solve <id> <length>\n
+//    <length bytes of level pack text>
+//
+// where <id> is an arbitrary token (without whitespace) that is echoed in the
+// response, and the text contains exactly one level (see levels/README.txt).
+//
+// For each request, the server sends a response consisting of "key: value"
+// lines, terminated by an empty line:
+//
+//    id: <id>
+//    status: solved | unsolvable | incomplete | cancelled | error |
+//            time-limit | memory-limit
+//    expanded: <number of states expanded>     (if a search was done)
+//    moves: <n>                                (if status is solved)
+//    <n lines, each containing a move>         (if status is solved)
+//    error: <message>                          (if status is error)
+//
+// If a request header is malformed, the server responds with status error
+// (echoing the id only if the header contains one), and closes the
+// connection without reading further requests.
+//
+// Status incomplete means that an incomplete search (like beam search) ended
+// without finding a solution, which does not prove that there is none.
+//
+// Requests are queued and solved by a fixed pool of worker threads. When a
+// client sends a new request before the previous one has been answered, the
+// previous request is cancelled. Responses may therefore arrive out of order.
+//
+// When a client closes its end of the connection for writing, the server
+// answers all outstanding requests and then closes the connection.
+
+struct ServeOptions {
+  SolveOptions solve;
+
+  // Persistent cache to use (in addition to the in-memory cache of recent
+  // results), or null.
+  const SolutionCache *cache = nullptr;
+
+  // Number of worker threads.
+  int threads = 1;
+
+  // Number of results kept in memory.
+  size_t recent_results = 1000;
+};
+
+// Listens for requests on a Unix domain socket at the given path (which is
+// replaced if it exists), until the process is terminated. Returns a nonzero
+// exit status if the server could not be started.
+int Serve(const std::string &socket_path, const ServeOptions &options);
+
+#endif  // ndef SERVER_H_INCLUDED
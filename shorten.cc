@@ -0,0 +1,114 @@
+#include "shorten.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "level.h"
+#include "search-monitor.h"
+#include "state-set.h"
+
+namespace {
+
+// Maximum number of states visited by the search for a single shortcut.
+constexpr size_t MAX_SHORTCUT_STATES = 5000;
+
+// A shortcut from steps[begin] to steps[end] (or, if `end` is the last step,
+// to any solved level), which takes fewer moves than the path.
+struct Shortcut {
+  int begin;
+  int end;
+
+  // Levels from steps[begin] to steps[end], inclusive.
+  std::vector<Level> levels;
+};
+
+// Searches for the shortcut from steps[begin] that saves the most moves.
+// `positions` maps the key of each level on the path to its last position.
+// If `monitor` reports that the search must stop, this sets `stopped`, and
+// returns the best shortcut found so far.
+std::optional<Shortcut> FindShortcut(
+    const std::vector<Level> &steps, int begin, int max_depth,
+    const std::unordered_map<std::string, int> &positions, SearchMonitor &monitor, bool &stopped) {
+  const int last = steps.size() - 1;
+  const Level &start = steps[begin];
+  StateSet states(start.KeySize());
+  std::vector<int32_t> parents;
+  states.Insert(start.Key());
+  parents.push_back(-1);
+
+  int best_saving = 0;
+  int32_t best_id = -1;
+  int best_end = -1;
+  uint32_t layer_begin = 0;
+  uint32_t layer_end = 1;
+  // A shortcut of `depth` moves can save at most last - begin - depth moves.
+  for (int depth = 1; depth <= max_depth && last - begin - depth > best_saving; ++depth) {
+    for (uint32_t id = layer_begin; id < layer_end && states.Size() < MAX_SHORTCUT_STATES; ++id) {
+      if (monitor.Check(depth, layer_end - id, states.Size())) {
+        stopped = true;
+        break;
+      }
+      Level level = start.FromKey(states.Key(id));
+      for (Level &next : level.Successors()) {
+        std::string key = next.Key();
+        auto [next_id, inserted] = states.Insert(key);
+        if (!inserted) continue;
+        parents.push_back(id);
+        int end = -1;
+        if (next.Solved()) {
+          end = last;
+        } else if (auto it = positions.find(key); it != positions.end()) {
+          end = it->second;
+        }
+        if (end - begin - depth > best_saving) {
+          best_saving = end - begin - depth;
+          best_id = next_id;
+          best_end = end;
+        }
+      }
+    }
+    layer_begin = layer_end;
+    layer_end = states.Size();
+    if (stopped || layer_begin == layer_end) break;
+  }
+  if (best_id < 0) return {};
+
+  Shortcut shortcut = {.begin = begin, .end = best_end, .levels = {}};
+  for (int32_t id = best_id; id >= 0; id = parents[id]) {
+    shortcut.levels.push_back(id == 0 ? start : start.FromKey(states.Key(id)));
+  }
+  std::reverse(shortcut.levels.begin(), shortcut.levels.end());
+  return shortcut;
+}
+
+}  // namespace
+
+std::vector<Level> ShortenSolution(std::vector<Level> steps, int max_depth, SearchMonitor &monitor) {
+  bool stopped = false;
+  for (bool improved = true; improved && !stopped; ) {
+    improved = false;
+    std::unordered_map<std::string, int> positions;
+    for (int i = 0; i < steps.size(); ++i) positions[steps[i].Key()] = i;
+    for (int begin = 0; begin + 2 < steps.size() && !stopped; ++begin) {
+      std::optional<Shortcut> shortcut = FindShortcut(steps, begin, max_depth, positions, monitor, stopped);
+      if (!shortcut) continue;
+      std::vector<Level> shortened(
+          std::make_move_iterator(steps.begin()), std::make_move_iterator(steps.begin() + begin));
+      shortened.insert(shortened.end(),
+          std::make_move_iterator(shortcut->levels.begin()), std::make_move_iterator(shortcut->levels.end()));
+      shortened.insert(shortened.end(),
+          std::make_move_iterator(steps.begin() + shortcut->end + 1), std::make_move_iterator(steps.end()));
+      steps = std::move(shortened);
+      positions.clear();
+      for (int i = 0; i < steps.size(); ++i) positions[steps[i].Key()] = i;
+      improved = true;
+    }
+  }
+  return steps;
+}
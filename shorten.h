@@ -0,0 +1,26 @@
+#ifndef SHORTEN_H_INCLUDED
+#define SHORTEN_H_INCLUDED
+
+#include <vector>
+
+#include "level.h"
+#include "search-monitor.h"
+
+// Shortens a solution (a sequence of levels, as in SolveResult::steps) that
+// is not necessarily a shortest one, by replacing detours with shortcuts.
+//
+// From each level on the path, a breadth-first search of at most `max_depth`
+// moves (and a bounded number of states) looks for a later level on the path,
+// or for any solved level, that can be reached in fewer moves than the path
+// takes. The best shortcut found is spliced in, and the path is scanned again
+// until no more shortcuts are found.
+//
+// Each search is tiny compared to an optimal search from the initial level,
+// but the result is not necessarily optimal either.
+//
+// Shortening stops early (returning the shortest path found so far) when
+// `monitor` reports that the time limit was exceeded or the search was
+// cancelled.
+std::vector<Level> ShortenSolution(std::vector<Level> steps, int max_depth, SearchMonitor &monitor);
+
+#endif  // ndef SHORTEN_H_INCLUDED
@@ -0,0 +1,140 @@
+#include "solution-cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "level.h"
+#include "search.h"
+#include "state-set.h"
+
+namespace {
+
+const char CACHE_HEADER[] = "jelly-solution-cache 1";
+
+}  // namespace
+
+std::string CanonicalLayout(const Level &level) {
+  std::ostringstream oss;
+  oss << level.Width() << 'x' << level.Height() << ' ' << level.Walls() << ' ' << std::hex;
+  for (char ch : level.Key()) {
+    oss << std::setw(2) << std::setfill('0') << int{static_cast<uint8_t>(ch)};
+  }
+  return oss.str();
+}
+
+bool ShouldCache(const SolveResult &result, SearchAlgorithm algorithm) {
+  return result.status == SolveStatus::UNSOLVABLE ||
+      (result.status == SolveStatus::SOLVED && FindsShortestSolutions(algorithm));
+}
+
+std::string SolutionCache::PathFor(const std::string &layout) const {
+  std::ostringstream oss;
+  oss << std::hex << std::setw(16) << std::setfill('0') << HashKey(layout) << ".txt";
+  return (std::filesystem::path(dir) / oss.str()).string();
+}
+
+std::optional<SolveResult> SolutionCache::Lookup(const Level &level) const {
+  const std::string layout = CanonicalLayout(level);
+  std::ifstream ifs(PathFor(layout));
+  std::string line;
+  if (!std::getline(ifs, line) || line != CACHE_HEADER) return {};
+  if (!std::getline(ifs, line) || line != "level: " + layout) return {};
+
+  SolveResult result;
+  std::optional<int> move_count;
+  while (!move_count && std::getline(ifs, line)) {
+    std::istringstream iss(line);
+    std::string key;
+    iss >> key;
+    if (key == "status:") {
+      std::string status;
+      iss >> status;
+      if (status == "solved") {
+        result.status = SolveStatus::SOLVED;
+      } else if (status == "unsolvable") {
+        result.status = SolveStatus::UNSOLVABLE;
+      } else {
+        return {};
+      }
+    } else if (key == "expanded:") {
+      iss >> result.expanded;
+    } else if (key == "moves:") {
+      int n = -1;
+      if (!(iss >> n) || n < 0) return {};
+      move_count = n;
+    }
+  }
+  if (!move_count) return {};
+  if (result.status == SolveStatus::UNSOLVABLE) return result;
+
+  std::vector<Move> moves;
+  for (int i = 0; i < *move_count; ++i) {
+    std::optional<Move> move;
+    if (!std::getline(ifs, line) || !(move = ParseMove(line))) return {};
+    moves.push_back(*move);
+  }
+  std::optional<std::vector<Level>> steps = ReplayMoves(level, moves);
+  if (!steps) return {};
+  if (verify) {
+    for (size_t i = 0; i + 1 < steps->size(); ++i) {
+      if ((*steps)[i].Solved()) return {};
+    }
+    if (!steps->back().Solved()) return {};
+  }
+  result.steps = std::move(*steps);
+  return result;
+}
+
+bool SolutionCache::Store(const Level &level, const SolveResult &result, double seconds) const {
+  std::vector<Move> moves;
+  if (result.status == SolveStatus::SOLVED) {
+    std::optional<std::vector<Move>> opt_moves = ExtractMoves(result.steps);
+    if (!opt_moves) return false;
+    moves = std::move(*opt_moves);
+  } else if (result.status != SolveStatus::UNSOLVABLE) {
+    return false;
+  }
+
+  const std::string layout = CanonicalLayout(level);
+  const std::string path = PathFor(layout);
+
+  // Write to a temporary file first, so that concurrent readers never observe
+  // a partially-written entry.
+  std::ostringstream temp_suffix;
+  temp_suffix << ".tmp." << getpid() << '.' << std::this_thread::get_id();
+  const std::string temp_path = path + temp_suffix.str();
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  {
+    std::ofstream ofs(temp_path);
+    ofs << CACHE_HEADER << '\n'
+        << "level: " << layout << '\n'
+        << "status: " << (result.status == SolveStatus::SOLVED ? "solved" : "unsolvable") << '\n'
+        << "expanded: " << result.expanded << '\n'
+        << "seconds: " << seconds << '\n';
+    if (result.stats) {
+      // A summary of the statistics, for reference only: Lookup() ignores it.
+      ofs << "generated: " << result.stats->generated << '\n'
+          << "duplicate-ratio: " << result.stats->DuplicateRatio() << '\n'
+          << "max-depth: " << int(result.stats->layers.size()) - 1 << '\n';
+    }
+    ofs << "moves: " << moves.size() << '\n';
+    for (const Move &move : moves) ofs << move << '\n';
+    if (!ofs.flush()) {
+      std::filesystem::remove(temp_path, ec);
+      return false;
+    }
+  }
+  return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,58 @@
+#ifndef SOLUTION_CACHE_H_INCLUDED
+#define SOLUTION_CACHE_H_INCLUDED
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "level.h"
+#include "search.h"
+
+// Returns a canonical description of a level, consisting of its dimensions,
+// static layout (see Level::Walls()) and the hex-encoded key of its movable
+// blocks (see Level::Key()). Levels with the same layout are equivalent.
+std::string CanonicalLayout(const Level &level);
+
+// Returns whether a result found by the given algorithm should be stored in a
+// cache: only shortest solutions are cached, but any search may prove that
+// there is no solution.
+bool ShouldCache(const SolveResult &result, SearchAlgorithm algorithm);
+
+// A persistent cache of search results, stored as one file per level in a
+// directory.
+//
+// Levels are identified by a hash of their canonical layout, which does not
+// depend on how blocks are grouped or numbered. The complete layout is stored
+// in the file too, so hash collisions are detected.
+//
+// Each file contains the solution as a list of moves (or records that the
+// level is unsolvable) together with the number of states expanded and the
+// search time, plus the number of states generated, the duplicate ratio and
+// the maximum depth if statistics were collected. When a cached solution is
+// used, the moves are replayed to reconstruct the intermediate levels. If
+// `verify` is true, the replayed solution is also checked to end in a solved
+// state (and not earlier); invalid entries are treated as misses.
+//
+// Entries are written atomically, so a cache directory may be shared between
+// concurrent processes.
+class SolutionCache {
+public:
+  SolutionCache(std::string dir, bool verify) : dir(std::move(dir)), verify(verify) {}
+
+  // Returns the cached result for the given level, if any.
+  std::optional<SolveResult> Lookup(const Level &level) const;
+
+  // Stores the result of a completed search (i.e., with status SOLVED or
+  // UNSOLVABLE) for the given level. Returns false if the result could not be
+  // written.
+  bool Store(const Level &level, const SolveResult &result, double seconds) const;
+
+private:
+  std::string PathFor(const std::string &layout) const;
+
+  std::string dir;
+  bool verify;
+};
+
+#endif  // ndef SOLUTION_CACHE_H_INCLUDED
@@ -1,393 +1,656 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <optional>
+#include <sstream>
 #include <string>
-#include <map>
-#include <set>
+#include <string_view>
 #include <vector>
 
-namespace {
+#include <signal.h>
+#include <unistd.h>
 
-// Orthogonal directions: left, right, down, up
-const int ND = 4;
-const int DR[ND] = {  0,  0, +1, -1 };
-const int DC[ND] = { -1, +1,  0,  0 };
+#include "checkpoint.h"
+#include "compact-search.h"
+#include "enumerate.h"
+#include "hint-db.h"
+#include "level.h"
+#include "parallel.h"
+#include "search.h"
+#include "search-stats.h"
+#include "server.h"
+#include "solution-cache.h"
 
-struct Point {
-  uint8_t r, c;
+namespace {
 
-  static Point Narrow(int r, int c) {
-    return Point{
-      .r = static_cast<uint8_t>(r),
-      .c = static_cast<uint8_t>(c)};
-  }
-};
+// Incremented by the SIGUSR1 handler, to make running searches report their
+// progress (see SolveOptions::progress_requests).
+std::atomic<int> progress_requests = 0;
 
-/*
-std::ostream &operator<<(std::ostream &os, const Point &p) {
-  return os << int{p.r} << ',' << int{p.c};
+void RequestProgress(int) {
+  ++progress_requests;
 }
-*/
 
-struct Cell {
-  enum Type : uint8_t {
-    OPEN = 0,
-    WALL = 1,
-    MOVABLE = 2,
-  };
-
-  Type type = OPEN;
-
-  // Only set if type == movable.
-  // 0 for black (which doesn't connect to anything)
-  // 1+ for a color
-  uint8_t color = 0;
+// Returns the current resident set size of the process in bytes, or 0 if it
+// cannot be determined.
+size_t ResidentSetSize() {
+  std::ifstream ifs("/proc/self/statm");
+  size_t total_pages = 0, resident_pages = 0;
+  if (!(ifs >> total_pages >> resident_pages)) return 0;
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
 
-  // 0 if type != movable.
-  // 1+ if type == movable; cells in the same group belong together.
-  uint8_t group = 0;
+// Writes a progress line for a running search to standard error, prefixed
+// with `tag` if it is not empty.
+void PrintProgress(const std::string &tag, const SearchProgress &progress) {
+  std::ostringstream oss;
+  if (!tag.empty()) oss << tag << ": ";
+  oss << "depth " << progress.depth
+      << ", frontier " << progress.frontier
+      << ", visited " << progress.visited
+      << ", " << std::fixed << std::setprecision(0)
+      << (progress.seconds > 0 ? progress.visited / progress.seconds : 0) << " states/s"
+      << ", RSS " << std::setprecision(1) << ResidentSetSize() / 1048576.0 << " MiB"
+      << ", " << progress.seconds << " s\n";
+  std::cerr << oss.str() << std::flush;
+}
 
-  char Char() const {
-    return type == OPEN ? ' ' : type == WALL ? '#' : static_cast<char>('0' + color);
+void PrintEnumeration(std::ostream &os, const Enumeration &enumeration, double seconds) {
+  const std::vector<EnumerateLayer> &layers = enumeration.layers;
+  int64_t solved = 0;
+  int64_t dead_ends = 0;
+  for (const EnumerateLayer &layer : layers) {
+    solved += layer.solved;
+    dead_ends += layer.dead_ends;
   }
+  os << "Enumerated " << enumeration.states.Size() << " states in "
+      << std::fixed << std::setprecision(3) << seconds << " seconds.\n"
+      << "Maximum depth: " << layers.size() - 1 << '\n'
+      << "Solved states: " << solved << '\n'
+      << "Dead ends: " << dead_ends << '\n'
+      << '\n'
+      << std::setw(5) << "Depth" << ' '
+      << std::setw(12) << "States" << ' '
+      << std::setw(12) << "Solved" << ' '
+      << std::setw(12) << "Dead ends" << '\n';
+  for (int depth = 0; depth < layers.size(); ++depth) {
+    const EnumerateLayer &layer = layers[depth];
+    os << std::setw(5) << depth << ' '
+        << std::setw(12) << layer.states << ' '
+        << std::setw(12) << layer.solved << ' '
+        << std::setw(12) << layer.dead_ends << '\n';
+  }
+  os << std::flush;
+}
 
-  auto operator<=>(const Cell&) const = default;
-};
-
-// Maybe TODO: normalize groups to deduplicate states?
-class Level {
-private:
-  // Width of the level, including padding walls on the left and right.
-  int width;
-
-  // Height of the level, including padding walls on the left and right.
-  int height;
-
-  // Number of movable groups in the level. Groups are numbered from 1 to
-  // `groups`, inclusive.
-  int groups;
-
-  // Cells of the grid in row-major order (i.e. a vector of `height` vectors
-  // of length `width`, each describing a row of the grid).
-  std::vector<std::vector<Cell>> grid;
-
-public:
-  Level(Level&&) = default;
-  Level(const Level&) = default;
-
-  Level& operator=(Level&&) = default;
-  Level& operator=(const Level&) = default;
-
-  Level(const std::vector<std::string> &input) :
-      width(input[0].size() + 2),
-      height(input.size() + 2),
-      groups(0),
-      grid(std::vector<std::vector<Cell>>(height, std::vector<Cell>(width))) {
-    for (int r = 0; r < height; ++r) {
-      for (int c = 0; c < width; ++c) {
-        if (r == 0 || r == height - 1 || c == 0 || c == width - 1) {
-          grid[r][c] = Cell{.type = Cell::WALL};
-        } else {
-          char ch = input[r - 1][c - 1];
-          if (ch == '#') {
-            grid[r][c] = Cell{.type = Cell::WALL};
-          } else if (ch >= '1' && ch <= '9') {
-            grid[r][c] = Cell{
-              .type = Cell::MOVABLE,
-              .color = static_cast<uint8_t>(ch - '0'),
-              .group = static_cast<uint8_t>(++groups)};
-          }
-        }
-      }
+// Parses a size in bytes, with an optional suffix K, M or G (for powers of
+// 1024). Returns an empty optional if the size is malformed.
+std::optional<size_t> ParseSize(std::string_view s) {
+  size_t size = 0;
+  size_t i = 0;
+  while (i < s.size() && s[i] >= '0' && s[i] <= '9') size = 10 * size + (s[i++] - '0');
+  if (i == 0) return {};
+  if (i + 1 == s.size()) {
+    switch (s[i]) {
+      case 'K': return size << 10;
+      case 'M': return size << 20;
+      case 'G': return size << 30;
     }
-    UpdateConnections();
   }
+  if (i != s.size()) return {};
+  return size;
+}
 
-  int Groups() const {
-    return groups;
+// Reads all levels from the given level pack file. Returns an empty optional
+// (after writing an error message to `log`) on failure. The result may be an
+// empty list, if the file does not contain any levels.
+std::optional<std::vector<PackEntry>> LoadLevelPack(const std::string &filename, std::ostream &log) {
+  std::ifstream ifs(filename);
+  if (!ifs) {
+    log << "Failed to open input file (" << filename << ")!" << std::endl;
+    return {};
   }
-
-  void Print(std::ostream &os) {
-    os << "+-";
-    for (int c = 1; c < width; ++c) os << "--";
-    os << "+" << std::endl;
-    for (int r = 0; r < height; ++r) {
-      os << '|';
-      for (int c = 0; c < width; ++c) {
-        const Cell &cell = grid[r][c];
-        os << cell.Char();
-        if (c + 1 < width) {
-          os << (cell.type == grid[r][c + 1].type && cell.group == grid[r][c + 1].group ? ' ' : '|');
-        }
-      }
-      os << "|\n";
-      if (r + 1 < height) {
-        os << '|';
-        for (int c = 0; c < width; ++c) {
-          const Cell &cell = grid[r][c];
-          os << (cell.type == grid[r + 1][c].type && cell.group == grid[r + 1][c].group ? ' ' : '-');
-          if (c + 1 < width) {
-            os << (cell.type == grid[r + 1][c].type && cell.group == grid[r + 1][c].group &&
-              cell.type == grid[r][c + 1].type && cell.group == grid[r][c + 1].group &&
-              cell.type == grid[r + 1][c + 1].type && cell.group == grid[r + 1][c + 1].group ? "·" : "+");
-          }
-        }
-        os << "|\n";
-      }
-    }
-    os << "+-";
-    for (int c = 1; c < width; ++c) os << "--";
-    os << "+" << std::endl;
+  std::string error;
+  std::optional<std::vector<PackEntry>> entries = ReadLevelPack(ifs, &error);
+  if (!entries) {
+    log << "Failed to read level (" << filename << ", " << error << ")!" << std::endl;
   }
+  return entries;
+}
 
-  auto operator<=>(const Level &) const = default;
+void PrintSteps(std::ostream &os, const std::vector<Level> &steps) {
+  for (int i = 0; i != steps.size(); ++i) {
+    os << "\nStep " << i << ":\n";
+    steps[i].Print(os);
+  }
+}
 
-  bool MoveGroup(uint8_t group, int dr, int dc) {
-        assert((dr == 0 && (dc == -1 || dc == +1)) || (dc == 0 && (dr == -1 || dr == +1)));
-    assert(group > 0 && group <= groups);
-    for (int r = 1; r + 1 < height; ++r) {
-      for (int c = 1; c + 1 < width; ++c) {
-        if (grid[r][c].group == group) {
-          if (!TryMove(r, c, dr, dc)) return false;
-          DropDown();
-          UpdateConnections();
-          return true;
-        }
-      }
+void PrintSolveResult(std::ostream &os, const SolveResult &result) {
+  switch (result.status) {
+    case SolveStatus::SOLVED:
+      os << "Found a solution in " << result.steps.size() - 1 << " steps.\n";
+      PrintSteps(os, result.steps);
+      break;
+    case SolveStatus::UNSOLVABLE:
+      os << "No solution found!\n";
+      break;
+    case SolveStatus::TIME_LIMIT_EXCEEDED:
+      os << "Time limit exceeded!\n";
+      break;
+    case SolveStatus::MEMORY_LIMIT_EXCEEDED:
+      os << "Memory limit exceeded!\n";
+      break;
+    case SolveStatus::CANCELLED:
+      os << "Search cancelled!\n";
+      break;
+    case SolveStatus::INCOMPLETE:
+      os << "No solution found, but the search was incomplete!\n";
+      break;
+  }
+  if (result.status != SolveStatus::SOLVED && result.status != SolveStatus::UNSOLVABLE) {
+    if (result.lower_bound > 0) {
+      os << "A solution needs at least " << result.lower_bound << " steps.\n";
+    }
+    if (!result.steps.empty()) {
+      os << "Found a solution in " << result.steps.size() - 1 << " steps (not necessarily optimal).\n";
+      PrintSteps(os, result.steps);
     }
-    assert(false);   // group not found
-    return false;
   }
+  os << std::flush;
+}
 
-  std::vector<Level> Successors() const {
-    Level copy = *this;
-    std::vector<Level> result;
-    for (int g = 1; g <= groups; ++g) {
-      for (int dc : {-1, +1}) {
-        if (copy.MoveGroup(g, 0, dc)) {
-          result.push_back(std::move(copy));
-          copy = *this;
-        }
+// Solves a level, writing the result to `os`, and diagnostics to `log`.
+// If `cache` is not null, it is used to look up and store results. Search
+// statistics are added to the diagnostics in the given format, unless the
+// result was cached.
+// Returns false if the search was aborted, or if the solution length does not
+// match the expected optimal length.
+bool SolveLevel(
+    const PackEntry &entry, SolveOptions options, StatsFormat stats_format,
+    const SolutionCache *cache, std::ostream &os, std::ostream &log) {
+  std::optional<SolveResult> cached;
+  if (cache != nullptr) cached = cache->Lookup(entry.level);
+  if (cached) log << "Using cached result.\n";
+  options.collect_stats = stats_format != StatsFormat::NONE;
+  auto start_time = std::chrono::steady_clock::now();
+  SolveResult result = cached ? std::move(*cached) : Solve(entry.level, options);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+  if (cache != nullptr && !cached && ShouldCache(result, options.algorithm) &&
+      !cache->Store(entry.level, result, elapsed.count())) {
+    log << "Failed to store result in cache!\n";
+  }
+  bool success = true;
+  switch (result.status) {
+    case SolveStatus::SOLVED:
+      log << "Solution found (expanded " << result.expanded << " states)\n";
+      break;
+    case SolveStatus::UNSOLVABLE:
+      log << "No solution found (expanded " << result.expanded << " states)\n";
+      break;
+    case SolveStatus::TIME_LIMIT_EXCEEDED:
+    case SolveStatus::MEMORY_LIMIT_EXCEEDED:
+    case SolveStatus::CANCELLED:
+      log << "Search aborted (expanded " << result.expanded << " states)\n";
+      success = false;
+      break;
+    case SolveStatus::INCOMPLETE:
+      log << "Search ended without a solution (expanded " << result.expanded << " states)\n";
+      success = false;
+      break;
+  }
+  switch (result.strategy) {
+    case SearchStrategy::BFS:
+      break;
+    case SearchStrategy::COMPACT_BFS:
+      // Searches with checkpoints use packed states from the start.
+      if (options.checkpoint_dir.empty() && options.resume == nullptr) {
+        log << "Memory limit reached; switched to packed states.\n";
       }
+      break;
+    case SearchStrategy::ITERATIVE_DEEPENING:
+      log << "Memory limit reached; switched to iterative deepening.\n";
+      break;
+    case SearchStrategy::BEST_FIRST:
+    case SearchStrategy::BEAM:
+    case SearchStrategy::IDA_STAR:
+      break;
+  }
+  if (result.stats) {
+    if (stats_format == StatsFormat::JSON) {
+      PrintSearchStatsJson(log, *result.stats);
+    } else {
+      PrintSearchStats(log, *result.stats);
     }
-
-    std::sort(result.begin(), result.end());
-    result.erase(std::unique(result.begin(), result.end()), result.end());
-    return result;
   }
-
-  bool Solved() {
-    // Maybe TODO: we can calculate this on the fly by keep tracking of groups being merged.
-
-    // Note: it's not sufficient to check that each color exists only in one group
-    // since two blocks can be connected through a black block, which means they are
-    // part of the same group but the colors don't touch.
-    std::vector<std::vector<char>> visited(height, std::vector<char>(width, char{false}));
-    std::set<int> colors;
-    for (int r = 1; r + 1 < height; ++r) {
-      for (int c = 1; c + 1 < width; ++c) {
-        if (!visited[r][c] && grid[r][c].type == Cell::MOVABLE && grid[r][c].color > 0) {
-          if (!colors.insert(grid[r][c].color).second) {
-            // second group of one color discovered
-            return false;
-          }
-          MarkColorVisited(r, c, visited);
-        }
-      }
+  if (entry.optimal && success) {
+    int length = result.status == SolveStatus::SOLVED ? result.steps.size() - 1 : -1;
+    // Cached solutions are always optimal.
+    const bool optimal = cached || FindsShortestSolutions(options.algorithm);
+    if (optimal ? length != *entry.optimal : length < *entry.optimal) {
+      log << "Expected a solution of " << *entry.optimal << " steps!\n";
+      success = false;
     }
-    return true;
   }
+  PrintSolveResult(os, result);
+  return success;
+}
 
-private:
+// A level to be solved in batch mode.
+struct BatchJob {
+  PackEntry entry;
 
-  void UpdateConnections() {
-    for (int r = 1; r + 1 < height; ++r) {
-      for (int c = 1; c + 1 < width; ++c) {
-        const Cell &cell = grid[r][c];
-        if (cell.type == Cell::MOVABLE && cell.color > 0) {
-          const Cell &right = grid[r][c + 1];
-          if (right.type == Cell::MOVABLE && right.group != cell.group && right.color == cell.color) {
-            int g = right.group;
-            Regroup(r, c + 1, g, cell.group);
-            RemoveUnusedGroupNumber(g);
-          }
-          const Cell &down = grid[r + 1][c];
-          if (down.type == Cell::MOVABLE && down.group != cell.group && down.color == cell.color) {
-            int g = down.group;
-            Regroup(r + 1, c, g, cell.group);
-            RemoveUnusedGroupNumber(g);
-          }
-        }
-      }
-    }
-  }
+  // Identifies the level in the output: the filename, followed by the index
+  // of the level if the file contains more than one.
+  std::string tag;
 
-  void Regroup(int r, int c, int from, int to) {
-    if (grid[r][c].group != from) return;
-    grid[r][c].group = to;
-    Regroup(r - 1, c, from, to);
-    Regroup(r + 1, c, from, to);
-    Regroup(r, c - 1, from, to);
-    Regroup(r, c + 1, from, to);
-  }
+  // Filename to use when writing results to an output directory.
+  std::string output_filename;
+};
 
-  void RemoveUnusedGroupNumber(int g) {
-    assert(g > 0 && g <= groups);
-    for (int r = 1; r + 1 < height; ++r) {
-      for (int c = 1; c + 1 < width; ++c) {
-        assert(grid[r][c].group != g);
-        if (grid[r][c].group > g) --grid[r][c].group;
-      }
+// Solves many levels concurrently, one per thread. Results are either written
+// to a file per level in `output_dir` (if not null), or to standard output,
+// each preceded by a header line with the level's tag. Diagnostics are written
+// to standard error, prefixed with the tag.
+int SolveBatch(
+    const std::vector<std::string> &filenames, const SolveOptions &options,
+    StatsFormat stats_format, const SolutionCache *cache, int threads, const char *output_dir) {
+  std::vector<BatchJob> jobs;
+  int failures = 0;
+  for (const std::string &filename : filenames) {
+    std::optional<std::vector<PackEntry>> entries = LoadLevelPack(filename, std::cerr);
+    if (!entries) {
+      ++failures;
+      continue;
     }
-    --groups;
-  }
-
-  bool TryMove(int r, int c, int dr, int dc) {
-    // optimization: find some way to reuse this vector (allocate it in Successors()?)
-    std::vector<std::pair<Point, Cell>> points;
-    bool res = GrabMovable(points, r, c, dr, dc);
-    if (!res) dr = dc = 0;
-    for (const auto &p : points) {
-      int r2 = p.first.r + dr;
-      int c2 = p.first.c + dc;
-      assert(grid[r2][c2].type == Cell::OPEN);
-      grid[r2][c2] = std::move(p.second);
+    if (entries->empty()) {
+      // Not an error, since directories may contain notes (like a README).
+      std::cerr << filename << ": No levels found.\n";
+      continue;
     }
-    return res;
-  }
-
-  bool GrabMovable(std::vector<std::pair<Point, Cell>> &points, int r, int c, int dr, int dc) {
-    assert(grid[r][c].type == Cell::MOVABLE);
-    int g = grid[r][c].group;
-    points.emplace_back(Point::Narrow(r, c), std::move(grid[r][c]));
-    grid[r][c] = Cell();
-    for (int d = 0; d < ND; ++d) {
-      int r2 = r + DR[d];
-      int c2 = c + DC[d];
-      if (DR[d] == dr && DC[d] == dc) {
-        if (grid[r2][c2].type == Cell::WALL) return false;
-        if (grid[r2][c2].type == Cell::MOVABLE) {
-          if (!GrabMovable(points, r2, c2, dr, dc)) return false;
-        }
-      } else {
-        if (grid[r2][c2].type == Cell::MOVABLE && grid[r2][c2].group == g) {
-          if (!GrabMovable(points, r2, c2, dr, dc)) return false;
-        }
+    std::filesystem::path path(filename);
+    for (int i = 0; i < entries->size(); ++i) {
+      BatchJob job = {
+          .entry = std::move((*entries)[i]),
+          .tag = filename,
+          .output_filename = path.filename()};
+      if (entries->size() > 1) {
+        std::string index = std::to_string(i + 1);
+        job.tag += '#';
+        job.tag += index;
+        job.output_filename = path.stem().string() + '-' + index + path.extension().string();
       }
+      if (!job.entry.name.empty()) job.tag += " (" + job.entry.name + ")";
+      jobs.push_back(std::move(job));
     }
-    return true;
   }
 
-  void DropDown() {
-    // FIXME: this is very inefficient.
-    for (int r = 1; r + 1 < height; ++r) {
-      for (int c = 1; c + 1 < width; ++c) {
-        if (grid[r][c].type == Cell::MOVABLE) TryMove(r, c, 1, 0);
-      }
+  std::mutex output_mutex;
+  ParallelFor(jobs.size(), threads, [&](size_t i) {
+    const BatchJob &job = jobs[i];
+    std::ostringstream os, log;
+    SolveOptions job_options = options;
+    if (job_options.progress) {
+      job_options.progress = [&job](const SearchProgress &progress) { PrintProgress(job.tag, progress); };
     }
-  }
-
-  void MarkColorVisited(int r, int c, std::vector<std::vector<char>> &visited) {
-    visited[r][c] = true;
-    for (int d = 0; d < ND; ++d) {
-      int r2 = r + DR[d];
-      int c2 = c + DC[d];
-      if (grid[r2][c2].type == Cell::MOVABLE && grid[r2][c2].color == grid[r][c].color && !visited[r2][c2]) {
-        MarkColorVisited(r2, c2, visited);
+    auto start_time = std::chrono::steady_clock::now();
+    bool success = SolveLevel(job.entry, job_options, stats_format, cache, os, log);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    log << "Finished in " << std::fixed << std::setprecision(3) << elapsed.count() << " seconds\n";
+    if (output_dir != nullptr) {
+      std::filesystem::path output_path = std::filesystem::path(output_dir) / job.output_filename;
+      std::ofstream ofs(output_path);
+      if (!(ofs << os.str() << std::flush)) {
+        log << "Failed to write output file (" << output_path.string() << ")!\n";
+        success = false;
       }
     }
-  }
-};
 
-std::optional<Level> ReadLevel(std::istream &is) {
-  int width = 0;
-  int height = 0;
-  std::string line;
-  std::vector<std::string> grid;
-  while (std::getline(is, line) && !line.empty()) {
-    if (width == 0) {
-      if (line.size() == 0) return {};
-      width = line.size();
-    } else {
-      if (line.size() != width) return {};
+    std::lock_guard<std::mutex> lock(output_mutex);
+    if (!success) ++failures;
+    if (output_dir == nullptr) {
+      std::cout << "==> " << job.tag << " <==\n" << os.str() << std::endl;
+    }
+    std::istringstream lines(log.str());
+    for (std::string line; std::getline(lines, line); ) {
+      std::cerr << job.tag << ": " << line << '\n';
     }
-    grid.push_back(line);
-    ++height;
+    std::cerr << std::flush;
+  });
+  if (failures > 0) {
+    std::cerr << failures << " of " << jobs.size() << " levels failed." << std::endl;
+    return 1;
   }
-  if (width == 0 || height == 0) return {};
-  return {Level(grid)};
+  return 0;
 }
 
-std::vector<Level> Solve(Level initial_level) {
-  std::vector<Level> result;
-  if (initial_level.Solved()) {
-    result.push_back(std::move(initial_level));
-    return result;
-  }
+void PrintUsage() {
+  std::cout << "Usage: solve [options] <level.txt>...\n"
+      "\n"
+      "Levels are solved concurrently if more than one file is given. Directories\n"
+      "are expanded to the .txt files they contain.\n"
+      "\n"
+      "Options:\n"
+      "  --enumerate    explore the complete state space and print statistics\n"
+      "                 per depth, instead of searching for a solution\n"
+      "  --build-hints=FILE\n"
+      "                 compute the distance to a solved state for all reachable\n"
+      "                 states, and write them to a hint database\n"
+      "  --hint=FILE    look up the level in a hint database, and print the\n"
+      "                 distance to a solved state and the next move\n"
+      "  --specialize=FILE\n"
+      "                 write a header with the static layout of the level to\n"
+      "                 FILE, for building a solver specialized for that level\n"
+      "                 (see `make solve-<level>.opt`)\n"
+      "  --max-memory=N limit memory use (per level) to about N bytes (K, M or G\n"
+      "                 suffixes may be used); a search that reaches the limit\n"
+      "                 continues with slower strategies that need less memory\n"
+      "  --time-limit=S limit search time per level to S seconds; if no optimal\n"
+      "                 solution is found in time, a lower bound and the best\n"
+      "                 solution found by a faster greedy search are printed\n"
+      "  --algorithm=A  search algorithm: bfs (breadth-first search, the default)\n"
+      "                 or astar find shortest solutions; wastar (weighted A*)\n"
+      "                 and greedy (greedy best-first search) find longer\n"
+      "                 solutions, but usually much faster; beam (beam search)\n"
+      "                 uses little memory, but may miss solutions; idastar\n"
+      "                 (iterative-deepening A*) finds shortest solutions using\n"
+      "                 very little memory, and all threads for a single level\n"
+      "  --portfolio    run bfs, astar, greedy and beam concurrently (sharing the\n"
+      "                 memory limit), and stop when one finds a shortest solution;\n"
+      "                 if the time limit is exceeded first, the shortest solution\n"
+      "                 found so far is printed\n"
+      "  --weight=W     weight of the heuristic for wastar (default: 2); solutions\n"
+      "                 are at most W times longer than the shortest ones\n"
+      "  --heuristic=H  lower bound used by astar, wastar and idastar: gaps (the\n"
+      "                 column gaps between blocks of the same color) or pdb\n"
+      "                 (pattern databases of those gaps, the default)\n"
+      "  --beam-width=K number of states kept per depth by beam (default: 10000)\n"
+      "  --shortcut-depth=N\n"
+      "                 shorten solutions that are not necessarily shortest by\n"
+      "                 searching for shortcuts of up to N moves (default: 6;\n"
+      "                 0 disables this)\n"
+      "  --stats[=json] print search statistics (states generated and inserted,\n"
+      "                 time per phase and per depth, peak memory) to standard\n"
+      "                 error, as text or as a single line of JSON\n"
+      "  --progress[=S] report the progress of each search on standard error\n"
+      "                 every S seconds (default: 10); progress is also reported\n"
+      "                 when the process receives SIGUSR1\n"
+      "  --checkpoint=DIR\n"
+      "                 write the state of the search to DIR after each layer\n"
+      "  --resume=DIR   continue the search from the checkpoint in DIR (and keep\n"
+      "                 updating it)\n"
+      "  --cache-dir=DIR\n"
+      "                 look up solutions in (and add them to) a cache in DIR\n"
+      "  --verify-cache check cached solutions by replaying them\n"
+      "  --serve=SOCKET run as a daemon, answering requests on a Unix domain\n"
+      "                 socket (see solve-client); no level files are given\n"
+      "  --output-dir=DIR\n"
+      "                 write the solution of each level to a file in DIR, instead\n"
+      "                 of standard output\n"
+      "  --threads=N    number of worker threads to use (default: "
+      << DefaultThreadCount() << ")\n" << std::flush;
+}
 
-  std::map<Level, int> level_index;
-  std::vector<std::map<Level, int>::iterator> levels;
-  std::vector<int> previous_level_index;
-  levels.push_back(level_index.insert({std::move(initial_level), 0}).first);
-  previous_level_index.push_back(-1);
+}  // namespace
 
-  for (int i = 0; i < level_index.size(); ++i) {
-    const Level &level = levels[i]->first;
-    for (Level &next_level : level.Successors()) {
-      if (next_level.Solved()) {
-        std::cerr << "Solution found (expanded " << levels.size() << " states)\n";
-        result.push_back(next_level);
-        for (int j = i; j >= 0; j = previous_level_index[j]) {
-          result.push_back(levels[j]->first);
-        }
-        std::reverse(result.begin(), result.end());
-        return result;
+int main(int argc, char *argv[]) {
+  std::vector<std::string> inputs;
+  bool enumerate = false;
+  const char *hints_filename = nullptr;
+  const char *hint_db_filename = nullptr;
+  const char *specialize_filename = nullptr;
+  const char *output_dir = nullptr;
+  const char *cache_dir = nullptr;
+  bool verify_cache = false;
+  const char *socket_path = nullptr;
+  const char *resume_dir = nullptr;
+  SolveOptions solve_options;
+  StatsFormat stats_format = StatsFormat::NONE;
+  int threads = DefaultThreadCount();
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--enumerate") {
+      enumerate = true;
+    } else if (arg.starts_with("--build-hints=")) {
+      hints_filename = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--hint=")) {
+      hint_db_filename = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--specialize=")) {
+      specialize_filename = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--max-memory=")) {
+      std::optional<size_t> size = ParseSize(arg.substr(arg.find('=') + 1));
+      if (!size) {
+        std::cerr << "Invalid memory size: " << argv[i] << std::endl;
+        return 1;
+      }
+      solve_options.max_memory = *size;
+    } else if (arg.starts_with("--time-limit=")) {
+      solve_options.time_limit = std::atof(argv[i] + arg.find('=') + 1);
+      if (!(solve_options.time_limit > 0)) {
+        std::cerr << "Invalid time limit: " << argv[i] << std::endl;
+        return 1;
       }
-      int j = levels.size();
-      auto res = level_index.insert({std::move(next_level), j});
-      if (res.second) {
-        levels.push_back(res.first);
-        previous_level_index.push_back(i);
+    } else if (arg.starts_with("--algorithm=")) {
+      std::string_view name = arg.substr(arg.find('=') + 1);
+      if (name == "bfs") {
+        solve_options.algorithm = SearchAlgorithm::BFS;
+      } else if (name == "astar") {
+        solve_options.algorithm = SearchAlgorithm::ASTAR;
+      } else if (name == "wastar") {
+        solve_options.algorithm = SearchAlgorithm::WEIGHTED_ASTAR;
+      } else if (name == "greedy") {
+        solve_options.algorithm = SearchAlgorithm::GREEDY;
+      } else if (name == "idastar") {
+        solve_options.algorithm = SearchAlgorithm::IDA_STAR;
+      } else if (name == "beam") {
+        solve_options.algorithm = SearchAlgorithm::BEAM;
+      } else {
+        std::cerr << "Invalid algorithm: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--portfolio") {
+      solve_options.algorithm = SearchAlgorithm::PORTFOLIO;
+    } else if (arg.starts_with("--weight=")) {
+      solve_options.weight = std::atof(argv[i] + arg.find('=') + 1);
+      if (!(solve_options.weight >= 1)) {
+        std::cerr << "Invalid weight: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--heuristic=gaps") {
+      solve_options.pattern_database = false;
+    } else if (arg == "--heuristic=pdb") {
+      solve_options.pattern_database = true;
+    } else if (arg.starts_with("--beam-width=")) {
+      solve_options.beam_width = std::atoi(argv[i] + arg.find('=') + 1);
+      if (solve_options.beam_width < 1) {
+        std::cerr << "Invalid beam width: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg.starts_with("--shortcut-depth=")) {
+      solve_options.shortcut_depth = std::atoi(argv[i] + arg.find('=') + 1);
+      if (solve_options.shortcut_depth < 0) {
+        std::cerr << "Invalid shortcut depth: " << argv[i] << std::endl;
+        return 1;
       }
+    } else if (arg == "--stats" || arg == "--stats=text") {
+      stats_format = StatsFormat::TEXT;
+    } else if (arg == "--stats=json") {
+      stats_format = StatsFormat::JSON;
+    } else if (arg == "--progress") {
+      solve_options.progress_interval = 10;
+    } else if (arg.starts_with("--progress=")) {
+      solve_options.progress_interval = std::atof(argv[i] + arg.find('=') + 1);
+      if (!(solve_options.progress_interval > 0)) {
+        std::cerr << "Invalid progress interval: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg.starts_with("--checkpoint=")) {
+      solve_options.checkpoint_dir = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--resume=")) {
+      resume_dir = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--cache-dir=")) {
+      cache_dir = argv[i] + arg.find('=') + 1;
+    } else if (arg == "--verify-cache") {
+      verify_cache = true;
+    } else if (arg.starts_with("--serve=")) {
+      socket_path = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--output-dir=")) {
+      output_dir = argv[i] + arg.find('=') + 1;
+    } else if (arg.starts_with("--threads=")) {
+      threads = std::atoi(argv[i] + arg.find('=') + 1);
+      if (threads < 1) {
+        std::cerr << "Invalid number of threads: " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg.starts_with("-")) {
+      PrintUsage();
+      return 1;
+    } else {
+      inputs.push_back(argv[i]);
     }
   }
-  std::cerr << "No solution found (expanded " << levels.size() << " states)\n";
-  return result;
-}
-
-}  // namespace
+  std::optional<SolutionCache> cache;
+  if (cache_dir != nullptr) cache.emplace(cache_dir, verify_cache);
+  const SolutionCache *cache_ptr = cache ? &*cache : nullptr;
 
-int main(int argc, char *argv[]) {
-  if (argc != 2) {
-    std::cout << "Usage: solve <level.txt>" << std::endl;
+  if (solve_options.algorithm != SearchAlgorithm::BFS &&
+      (!solve_options.checkpoint_dir.empty() || resume_dir != nullptr)) {
+    std::cerr << "Checkpoints are only supported with --algorithm=bfs, without --portfolio!" << std::endl;
     return 1;
   }
-  const char *filename = argv[1];
-  std::optional<Level> opt_level;
-  {
-    std::ifstream ifs(filename);
-    if (!ifs) {
-      std::cerr << "Failed to open input file (" << filename << ")!" << std::endl;
+  if (resume_dir != nullptr && !solve_options.checkpoint_dir.empty() &&
+      solve_options.checkpoint_dir != resume_dir) {
+    std::cerr << "A resumed search can only write checkpoints to the same directory!" << std::endl;
+    return 1;
+  }
+  // Searches report their progress on SIGUSR1 (also in daemon mode, where
+  // the signal would otherwise terminate the process), and periodically with
+  // --progress.
+  struct sigaction action = {};
+  action.sa_handler = RequestProgress;
+  action.sa_flags = SA_RESTART;
+  sigaction(SIGUSR1, &action, nullptr);
+  solve_options.progress_requests = &progress_requests;
+  solve_options.progress = [](const SearchProgress &progress) { PrintProgress("", progress); };
+
+  if (socket_path != nullptr) {
+    if (!inputs.empty() || !solve_options.checkpoint_dir.empty() || resume_dir != nullptr) {
+      PrintUsage();
       return 1;
     }
-    opt_level = ReadLevel(ifs);
+    return Serve(socket_path, {
+        .solve = solve_options,
+        .cache = cache_ptr,
+        .threads = threads});
   }
-  if (!opt_level) {
-    std::cerr << "Failed to read level!" << std::endl;
+  if (inputs.empty()) {
+    PrintUsage();
     return 1;
   }
-  std::vector<Level> steps = Solve(std::move(*opt_level));
-  if (steps.empty()) {
-    std::cout << "No solution found!" << std::endl;
-  } else {
-    std::cout << "Found a solution in " << steps.size() - 1 << " steps.\n";
-    for (int i = 0; i != steps.size(); ++i) {
-      std::cout << "\nStep " << i << ":\n";
-      steps[i].Print(std::cout);
+
+  solve_options.anytime = true;
+
+  const bool single_level_mode = enumerate || hints_filename != nullptr || hint_db_filename != nullptr ||
+      specialize_filename != nullptr;
+  std::vector<std::string> filenames = ExpandLevelPaths(inputs);
+  std::optional<std::vector<PackEntry>> entries;
+  if (filenames.size() == 1 && inputs[0] == filenames[0] && output_dir == nullptr) {
+    entries = LoadLevelPack(filenames[0], std::cerr);
+    if (!entries) return 1;
+    if (entries->empty()) {
+      std::cerr << "Failed to read level!" << std::endl;
+      return 1;
+    }
+  }
+  if (!entries || entries->size() != 1) {
+    if (single_level_mode || !solve_options.checkpoint_dir.empty() || resume_dir != nullptr) {
+      std::cerr << "Only a single level may be given in this mode!" << std::endl;
+      return 1;
+    }
+    return SolveBatch(filenames, solve_options, stats_format, cache_ptr, threads, output_dir);
+  }
+
+  const PackEntry &entry = (*entries)[0];
+  std::optional<CompactSearch> checkpoint;
+  if (resume_dir != nullptr) {
+    checkpoint = ReadCheckpoint(resume_dir, entry.level);
+    if (!checkpoint) return 1;
+    solve_options.checkpoint_dir = resume_dir;
+    solve_options.resume = &*checkpoint;
+  }
+  if (!single_level_mode) {
+    // Only IDA* (and building pattern databases) uses more than one thread
+    // per level.
+    solve_options.threads = threads;
+    return SolveLevel(entry, solve_options, stats_format, cache_ptr, std::cout, std::cerr) ? 0 : 1;
+  }
+  const Level &level = entry.level;
+  if (specialize_filename != nullptr) {
+    std::ofstream ofs(specialize_filename);
+    WriteSpecializedShape(level, ofs);
+    if (!ofs.flush()) {
+      std::cerr << "Failed to write output file (" << specialize_filename << ")!" << std::endl;
+      return 1;
     }
-    std::cout << std::flush;
+    return 0;
+  }
+  if (hint_db_filename != nullptr) {
+    std::optional<HintDatabase> db = HintDatabase::Open(hint_db_filename);
+    if (!db) return 1;
+    if (!db->Matches(level)) {
+      std::cerr << "Level does not match the hint database!" << std::endl;
+      return 1;
+    }
+    std::optional<Hint> hint = db->Query(level);
+    if (!hint) {
+      std::cout << "State is not reachable from the initial state." << std::endl;
+      return 1;
+    }
+    if (hint->distance == HINT_DB_UNSOLVABLE) {
+      std::cout << "State is unsolvable." << std::endl;
+    } else if (hint->distance == 0) {
+      std::cout << "State is solved." << std::endl;
+    } else {
+      std::cout << "Distance to solution: " << hint->distance << '\n'
+          << "Next move: " << *hint->move << std::endl;
+    }
+    return 0;
+  }
+  if (enumerate) {
+    auto start_time = std::chrono::steady_clock::now();
+    Enumeration enumeration = Enumerate(level, {
+        .threads = threads,
+        .max_memory = solve_options.max_memory});
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    if (!enumeration.complete) {
+      std::cerr << "Memory limit exceeded; results are incomplete!" << std::endl;
+    }
+    PrintEnumeration(std::cout, enumeration, elapsed.count());
+    return enumeration.complete ? 0 : 1;
+  }
+  // Remaining mode: --build-hints.
+  std::optional<HintDbStats> stats = BuildHintDatabase(
+      level, {.threads = threads, .max_memory = solve_options.max_memory},
+      hints_filename);
+  if (!stats) return 1;
+  std::cout << "Wrote hint database to " << hints_filename << ".\n"
+      << "States: " << stats->states << " (" << stats->solvable << " solvable)\n"
+      << "Maximum distance: " << stats->max_distance << '\n';
+  if (stats->initial_distance == HINT_DB_UNSOLVABLE) {
+    std::cout << "The initial state is unsolvable.\n";
+  } else {
+    std::cout << "Distance of the initial state: " << stats->initial_distance << '\n';
+  }
+  if (!stats->used_edges) {
+    std::cout << "(Successors were recomputed to stay within the memory limit.)\n";
   }
+  std::cout << std::flush;
+  return 0;
 }
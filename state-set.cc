@@ -0,0 +1,44 @@
+#include "state-set.h"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+std::pair<uint32_t, bool> StateSet::Insert(std::string_view key) {
+  assert(key.size() == key_size);
+  if (2 * (Size() + 1) > table.size()) Grow();
+  size_t mask = table.size() - 1;
+  for (size_t i = HashKey(key) & mask; ; i = (i + 1) & mask) {
+    if (table[i] == 0) {
+      assert(Size() < std::numeric_limits<uint32_t>::max());
+      uint32_t id = Size();
+      keys.append(key);
+      table[i] = id + 1;
+      return {id, true};
+    }
+    if (Key(table[i] - 1) == key) return {table[i] - 1, false};
+  }
+}
+
+std::optional<uint32_t> StateSet::Find(std::string_view key) const {
+  assert(key.size() == key_size);
+  size_t mask = table.size() - 1;
+  for (size_t i = HashKey(key) & mask; table[i] != 0; i = (i + 1) & mask) {
+    if (Key(table[i] - 1) == key) return table[i] - 1;
+  }
+  return {};
+}
+
+void StateSet::Grow() {
+  std::vector<uint32_t> new_table(table.size() * 2, 0);
+  size_t mask = new_table.size() - 1;
+  for (uint32_t id = 0; id < Size(); ++id) {
+    size_t i = HashKey(Key(id)) & mask;
+    while (new_table[i] != 0) i = (i + 1) & mask;
+    new_table[i] = id + 1;
+  }
+  table.swap(new_table);
+}
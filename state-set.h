@@ -0,0 +1,81 @@
+#ifndef STATE_SET_H_INCLUDED
+#define STATE_SET_H_INCLUDED
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Returns a 64-bit FNV-1a hash of the given key.
+//
+// This is used instead of std::hash because the value must be stable across
+// builds: it also determines the layout of hash tables that are written to
+// disk.
+inline uint64_t HashKey(std::string_view key) {
+  uint64_t h = 0xcbf29ce484222325;
+  for (char ch : key) {
+    h ^= static_cast<uint8_t>(ch);
+    h *= 0x100000001b3;
+  }
+  return h;
+}
+
+// A set of fixed-size keys (see Level::Key()), which assigns each key a dense
+// id in order of insertion.
+//
+// Keys are stored back-to-back in a single buffer, and the hash table only
+// stores 32-bit ids, so the overhead per state is small compared to storing
+// Level objects in a std::map.
+//
+// Find() and Key() may be called concurrently, but not while Insert() runs.
+class StateSet {
+public:
+  explicit StateSet(int key_size) : key_size(key_size), table(16, 0) {}
+
+  // Number of keys in the set.
+  size_t Size() const {
+    return keys.size() / key_size;
+  }
+
+  int KeySize() const {
+    return key_size;
+  }
+
+  // Returns the key with the given id.
+  std::string_view Key(uint32_t id) const {
+    return std::string_view(keys).substr(size_t{id} * key_size, key_size);
+  }
+
+  // Returns the keys with ids from `begin` to `end` (exclusive), back to back.
+  std::string_view Keys(uint32_t begin, uint32_t end) const {
+    return std::string_view(keys).substr(size_t{begin} * key_size, size_t{end - begin} * key_size);
+  }
+
+  // Adds a key to the set, if it wasn't present already. Returns the id of the
+  // key and whether it was newly inserted.
+  std::pair<uint32_t, bool> Insert(std::string_view key);
+
+  // Returns the id of the given key, or an empty optional if it is absent.
+  std::optional<uint32_t> Find(std::string_view key) const;
+
+  // Approximate number of bytes of memory allocated by this set.
+  size_t MemoryUsage() const {
+    return keys.capacity() + table.capacity() * sizeof(table[0]);
+  }
+
+private:
+  void Grow();
+
+  int key_size;
+
+  // Concatenation of all keys, in order of insertion.
+  std::string keys;
+
+  // Open-addressing hash table with linear probing. Each slot contains either
+  // 0 (empty) or 1 + the id of a key. The size is always a power of 2.
+  std::vector<uint32_t> table;
+};
+
+#endif  // ndef STATE_SET_H_INCLUDED
@@ -0,0 +1,70 @@
+#ifndef TRANSPOSITION_TABLE_H_INCLUDED
+#define TRANSPOSITION_TABLE_H_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "state-set.h"
+
+// Transposition table for iterative deepening (see search.cc and ida-star.h),
+// of a fixed size. Each slot holds a key and the depth at which it was last
+// reached during the current iteration. Colliding keys simply replace each
+// other, so the table only prunes part of the duplicate states, but never
+// prunes incorrectly.
+//
+// If the table is created with `lock_count` > 0, Visit() may be called
+// concurrently: slots are then guarded by that many locks (slot i by lock
+// i % lock_count), so that threads rarely contend.
+class TranspositionTable {
+public:
+  TranspositionTable(int key_size, size_t slots, size_t lock_count = 0) :
+      key_size(key_size), slots(std::max<size_t>(slots, 1)), data(this->slots * SlotSize(key_size), '\0'),
+      locks(lock_count) {}
+
+  static size_t SlotSize(int key_size) {
+    return key_size + 2 * sizeof(uint16_t);
+  }
+
+  void NextIteration() {
+    ++iteration;
+  }
+
+  // Returns true if `key` was reached before in this iteration at a depth of
+  // at most `depth`. Otherwise, records it at `depth` and returns false. If
+  // `previous_depth` is not null, it is set to the depth at which `key` was
+  // recorded in this iteration, or to -1 if it was not.
+  bool Visit(std::string_view key, int depth, int *previous_depth = nullptr) {
+    const size_t index = HashKey(key) % slots;
+    std::unique_lock<std::mutex> lock;
+    if (!locks.empty()) lock = std::unique_lock<std::mutex>(locks[index % locks.size()]);
+    char *slot = &data[index * SlotSize(key_size)];
+    uint16_t slot_iteration, slot_depth;
+    std::memcpy(&slot_iteration, slot + key_size, sizeof(uint16_t));
+    std::memcpy(&slot_depth, slot + key_size + sizeof(uint16_t), sizeof(uint16_t));
+    const bool found = slot_iteration == iteration && key == std::string_view(slot, key_size);
+    if (previous_depth != nullptr) *previous_depth = found ? slot_depth : -1;
+    if (found && slot_depth <= depth) return true;
+    uint16_t d = depth;
+    std::memcpy(slot, key.data(), key_size);
+    std::memcpy(slot + key_size, &iteration, sizeof(uint16_t));
+    std::memcpy(slot + key_size + sizeof(uint16_t), &d, sizeof(uint16_t));
+    return false;
+  }
+
+private:
+  int key_size;
+  size_t slots;
+  std::string data;
+  std::vector<std::mutex> locks;
+
+  // Iteration 0 marks unused slots.
+  uint16_t iteration = 0;
+};
+
+#endif  // ndef TRANSPOSITION_TABLE_H_INCLUDED